@@ -1,4 +1,4 @@
-FILES = robot_main utility timers usart robot_sensor drive_control state_control led_control
+FILES = robot_main utility timers usart robot_sensor sensor_filter sensor_calib sensor_debounce sensor_scope sensor_estimate drive_table motor_output track_map track_laps drive_classify drive_script drive_control state_control led_control
 O_SRC = $(addprefix $(OUT_O_DIR)/, $(addsuffix .o, $(FILES)))
 C_SRC = $(addsuffix .c, $(FILES))
 H_SRC = $(addsuffix .h, $(FILES))
@@ -13,5 +13,7 @@ TARGET_FILE = $(OUT_O_DIR)/tmpfile
 DUDE_FLAGS = -p $(DEVICE) -c $(PROGRAMMER_ID) -P $(PORT) -b $(BAUD)
 CFLAGS = -mmcu=${DEVICE} -Os -D F_CPU=${F_CPU} -MMD -MP
 CC = avr-gcc
+HOST_CC = cc
+TOOLS_DIR = tools
 DOX = Doxyfile
 CPPCHECK_FLAGS = --enable=style,warning
\ No newline at end of file
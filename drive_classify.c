@@ -0,0 +1,71 @@
+#include "drive_classify.h"
+
+/**
+ * @brief Labels the track from the current averages alone
+ * @param classifier Classifier with the averages
+ * @return Label
+ */
+static segment_class classify_label(const curve_classifier *classifier) {
+    int16_t bias = abs(classifier->bias);
+    if (bias >= CLASSIFY_SHARP_BIAS) {
+        return CLASS_SHARP;
+    }
+    if (bias >= CLASSIFY_GENTLE_BIAS || classifier->share >= CLASSIFY_STRAIGHT_SHARE) {
+        return CLASS_GENTLE;
+    }
+    return CLASS_STRAIGHT;
+}
+
+void classify_reset(curve_classifier *classifier, uint32_t now) {
+    classifier->share = 0;
+    classifier->bias = 0;
+    classifier->label = CLASS_STRAIGHT;
+    classifier->pending = CLASS_STRAIGHT;
+    classifier->pending_time = 0;
+    classifier->last_time = now;
+}
+
+segment_class classify_update(curve_classifier *classifier, direction dir, uint32_t now) {
+    uint32_t elapsed = now - classifier->last_time;
+    if (elapsed > CLASSIFY_GAP) {
+        classify_reset(classifier, now);
+        return classifier->label;
+    }
+    classifier->last_time = now;
+    int16_t steer;
+    switch (dir) {
+        case DIR_FORWARD:
+            steer = 0;
+            break;
+        case DIR_RIGHT:
+            steer = CLASSIFY_ONE;
+            break;
+        case DIR_LEFT:
+            steer = -CLASSIFY_ONE;
+            break;
+        default:
+            // Neither a straight nor a curve, keep the history as it is
+            return classifier->label;
+    }
+    for (uint8_t i = 0; i < elapsed; ++i) {
+        classifier->share += (abs(steer) - classifier->share) >> CLASSIFY_SHIFT;
+        classifier->bias += (steer - classifier->bias) >> CLASSIFY_SHIFT;
+    }
+    segment_class label = classify_label(classifier);
+    if (label >= classifier->label) {
+        // Slower or the same, taken at once
+        classifier->label = label;
+        classifier->pending = label;
+        classifier->pending_time = 0;
+        return classifier->label;
+    }
+    if (label != classifier->pending) {
+        classifier->pending = label;
+        classifier->pending_time = 0;
+    }
+    classifier->pending_time += elapsed;
+    if (classifier->pending_time >= CLASSIFY_HOLD_TIME) {
+        classifier->label = label;
+    }
+    return classifier->label;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file
+ * @author Larson Schneider
+ * @date 17.10.2026
+ * @brief Classifies the part of the track the robot is on from its recent steering
+ * @version 0.1
+ * @copyright MIT License.
+ *
+ * This module labels the current part of the track as straight, gentle or sharp curve, only from
+ * the steering of the last few hundred milliseconds and without any map.
+ */
+/**
+ * @page classify Curve classifier module
+ * @tableofcontents
+ * The drive logic only knows the state of the sensors right now, so it can never tell if it is
+ * on a long straight or in a tight curve and has to drive every part at the same speed.
+ *
+ * @section secClaAvg Steering History
+ * Every millisecond the direction the robot drives is turned into a steering value, zero for
+ * forward and plus or minus one for a turn to the right or left. Two exponential moving averages
+ * with a time constant of 2^#CLASSIFY_SHIFT milliseconds follow it: the mean of the absolute
+ * value, how much of the time the robot steers, and the signed mean, how much it steers into one
+ * direction. On a straight the robot steers rarely and in both directions, so both stay small. In
+ * a curve it keeps steering into the same direction, and the sharper the curve the larger the
+ * signed mean gets.
+ *
+ * @section secClaLabel Labels
+ * - #CLASS_SHARP if the signed mean is above #CLASSIFY_SHARP_BIAS.
+ * - #CLASS_GENTLE if the signed mean is above #CLASSIFY_GENTLE_BIAS or the robot steers more than
+ *   #CLASSIFY_STRAIGHT_SHARE of the time.
+ * - #CLASS_STRAIGHT otherwise.
+ *
+ * A sharper label is taken at once, so the robot slows down as soon as a curve starts. A label
+ * that allows a higher speed has to hold for #CLASSIFY_HOLD_TIME milliseconds first. The whole
+ * state takes 12 bytes and an update only needs a few shifts and additions per millisecond.
+ * @sa #classify_update
+ */
+#ifndef DRIVE_CLASSIFY_H
+#define DRIVE_CLASSIFY_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "robot_types.h"
+
+/** @brief Value of a full turn in the steering averages, 12 fraction bits */
+#define CLASSIFY_ONE 4096
+/** @brief Time constant of the averages in milliseconds as power of two */
+#define CLASSIFY_SHIFT 7
+/** @brief Signed mean of the steering above which the robot is in a gentle curve */
+#define CLASSIFY_GENTLE_BIAS (CLASSIFY_ONE / 4)
+/** @brief Signed mean of the steering above which the robot is in a sharp curve */
+#define CLASSIFY_SHARP_BIAS (CLASSIFY_ONE * 5 / 8)
+/** @brief Share of the time the robot steers above which it is not on a straight anymore */
+#define CLASSIFY_STRAIGHT_SHARE (CLASSIFY_ONE / 2)
+/** @brief Time in milliseconds a label for a higher speed has to hold before it is taken */
+#define CLASSIFY_HOLD_TIME 200
+/** @brief Longest gap between two updates in milliseconds that is followed, longer ones restart */
+#define CLASSIFY_GAP 50
+
+/**
+ * @brief Kind of the part of the track the robot is on, ordered from the fastest to the slowest
+ */
+typedef enum {
+    /**
+     * @brief The robot barely steers, it can drive faster
+     */
+    CLASS_STRAIGHT,
+    /**
+     * @brief The robot steers into one direction now and then
+     */
+    CLASS_GENTLE,
+    /**
+     * @brief The robot steers into one direction most of the time, it has to drive slower
+     */
+    CLASS_SHARP
+} segment_class;
+
+/**
+ * @brief State of the classifier
+ */
+typedef struct curve_classifier {
+    /**
+     * @brief Mean of the absolute steering, #CLASSIFY_ONE if the robot always steers
+     */
+    int16_t share;
+    /**
+     * @brief Mean of the signed steering, positive to the right
+     */
+    int16_t bias;
+    /**
+     * @brief Current label
+     */
+    uint8_t label;
+    /**
+     * @brief Label that waits to be taken
+     */
+    uint8_t pending;
+    /**
+     * @brief Milliseconds the pending label has held
+     */
+    uint16_t pending_time;
+    /**
+     * @brief Time in milliseconds of the last update
+     */
+    uint32_t last_time;
+} curve_classifier;
+
+/**
+ * @brief Resets the classifier to a straight without any history
+ * @param classifier Classifier to reset
+ * @param now Current time in milliseconds
+ */
+void classify_reset(curve_classifier *classifier, uint32_t now);
+
+/**
+ * @brief Adds the steering since the last update and labels the track
+ * @param classifier Classifier to update
+ * @param dir Direction the robot drove since the last update
+ * @param now Current time in milliseconds
+ * @return Current label
+ */
+segment_class classify_update(curve_classifier *classifier, direction dir, uint32_t now);
+
+#endif
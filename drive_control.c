@@ -6,129 +6,128 @@ void motor_clear(void) {
     DR_MOTOR_SECOND = 0;
 }
 
+/**
+ * @brief Frames of the fixed moves, indexed by #motor_move
+ */
+static motor_frame motor_moves[MOVE_AMOUNT];
+/**
+ * @brief Duty of the wheels for every speed level of the manual control
+ */
+static const uint8_t manual_duties[MANUAL_LEVEL_AMOUNT] = {SPEED_SLOW, SPEED_STRAIT, SPEED_FAST};
+
 void motor_init(void) {
-    // Set PD5 and PD6 as output (EN[A|B]!)
-    DR_M_LE |= (1 << DP_M_LE);
-    DR_M_RE |= (1 << DP_M_RE);
-
-    // Set PD7 as output (IN1)
-    DR_M_LF |= (1 << DP_M_LF);
-
-    // Set PB0, PB1, and PB3 as output (IN[2|3|4])
-    DR_M_LB |= (1 << DP_M_LB);
-    DR_M_RB |= (1 << DP_M_RB);
-    DR_M_RF |= (1 << DP_M_RF);
-
-}
-
-void motor_set_duty(uint8_t pin, speed_value value) {
-    if (pin == OP_M_RE) {
-        if (value == 0) {
-            TIMER_0_WAVE &= TIMER_0_NORMAL_OPERATION_A;  // Normal port operation mode
-            OR_M_RE &= ~(1 << OP_M_RE);                       // PD6 LOW, equals 0% duty,
-        }                                             // timer disconnected
-        else if (value == 255) {
-            TIMER_0_WAVE &= TIMER_0_NORMAL_OPERATION_A;  // Normal port operation mode
-            OR_M_RE |= (1 << OP_M_RE);                        // PD6 HIGH, equals 100% duty,
-        }                                             // timer disconnected
-        else {
-            TIMER_0_WAVE |= (1 << COM0A1);                    // OC0A to LOW on Compare Match,
-            TIMER_0_WAVE &=
-                    ~(1 << COM0A0);                   // to HIGH at BOTTOM (non-inverting mode)
-            TIMER_0_COMPARE_RESOLUTION_A = (uint8_t) value;                              // generates sequences of 1-0-1-0...
-        }                                             // for certain periods of time
-    }
-
-    if (pin == OP_M_LE) {
-        if (value == 0) {
-            TIMER_0_WAVE &= TIMER_0_NORMAL_OPERATION_B;
-            OR_M_LE &= ~(1 << OP_M_LE);
-        } else if (value == 255) {
-            TIMER_0_WAVE &= TIMER_0_NORMAL_OPERATION_B;
-            OR_M_LE |= (1 << OP_M_LE);
-        } else {
-            TIMER_0_WAVE |= (1 << COM0B1);
-            TIMER_0_WAVE &= ~(1 << COM0B0);
-            TIMER_0_COMPARE_RESOLUTION_B = (uint8_t) value;
-        }
-    }
+    output_init();
+    output_build(&motor_moves[MOVE_STOP], OR_STOP, SPEED_ZERO, OR_STOP, SPEED_ZERO);
+    output_build(&motor_moves[MOVE_FORWARD], OR_FORWARDS, SPEED_STRAIT, OR_FORWARDS,
+                 SPEED_STRAIT);
+    output_build(&motor_moves[MOVE_FORWARD_FAST], OR_FORWARDS, SPEED_FAST, OR_FORWARDS,
+                 SPEED_FAST);
+    output_build(&motor_moves[MOVE_FORWARD_SLOW], OR_FORWARDS, SPEED_SLOW, OR_FORWARDS,
+                 SPEED_SLOW);
+    output_build(&motor_moves[MOVE_BACKWARD], OR_BACKWARDS, SPEED_STRAIT, OR_BACKWARDS,
+                 SPEED_STRAIT);
+    output_build(&motor_moves[MOVE_BACKWARD_SMOOTH], OR_BACKWARDS, SPEED_BACK_SMOOTH,
+                 OR_BACKWARDS, SPEED_BACK_SMOOTH);
+    output_build(&motor_moves[MOVE_LEFT], OR_BACKWARDS, SPEED_INNER, OR_FORWARDS, SPEED_OUTER);
+    output_build(&motor_moves[MOVE_RIGHT], OR_FORWARDS, SPEED_OUTER, OR_BACKWARDS, SPEED_INNER);
 }
 
 void motor_set_right(orientation dir, speed_value speed_state) {
-    if (dir == OR_FORWARDS) {
-        OR_M_RF |= (1 << OP_M_RF); // Forward ON
-        OR_M_RB &= ~(1 << OP_M_RB); // Backward OFF
-    } else if (dir == OR_BACKWARDS) {
-        OR_M_RF &= ~(1 << OP_M_RF); // Forward OFF
-        OR_M_RB |= (1 << OP_M_RB); // Backward ON
-    } else {
-        OR_M_RF &= ~(1 << OP_M_RF); // Forward OFF
-        OR_M_RB &= ~(1 << OP_M_RB); // Backward OFF
-        motor_set_duty(DP_M_LE, 0);
-        return;
-    }
-    motor_set_duty(DP_M_RE, speed_state);
+    motor_frame frame = *output_current();
+    output_set_right(&frame, dir, speed_state);
+    output_apply(&frame);
 }
 
 void motor_set_left(orientation dir, speed_value speed_state) {
-    if (dir == OR_FORWARDS) {
-        OR_M_LF |= (1 << OP_M_LF); // Forward ON
-        OR_M_LB &= ~(1 << OP_M_LB); // Backward OFF
-    } else if (dir == OR_BACKWARDS) {
-        OR_M_LF &= ~(1 << OP_M_LF); // Forward OFF
-        OR_M_LB |= (1 << OP_M_LB); // Backward ON
-    } else {
-        OR_M_LF &= ~(1 << OP_M_LF); // Forward OFF
-        OR_M_LB &= ~(1 << OP_M_LB); // Backward OFF
-        motor_set_duty(DP_M_LE, 0);
-        return;
+    motor_frame frame = *output_current();
+    output_set_left(&frame, dir, speed_state);
+    output_apply(&frame);
+}
+
+/**
+ * @brief Limits a signed duty to the range of a wheel
+ * @param duty Signed duty
+ * @return Duty between -#PID_DUTY_MAX and #PID_DUTY_MAX
+ */
+static int16_t motor_limit_duty(int16_t duty) {
+    if (duty > PID_DUTY_MAX) {
+        return PID_DUTY_MAX;
+    }
+    if (duty < -PID_DUTY_MAX) {
+        return -PID_DUTY_MAX;
     }
-    motor_set_duty(DP_M_LE, speed_state);
+    return duty;
+}
+
+void motor_set_wheels(int16_t left, int16_t right) {
+    left = motor_limit_duty(left);
+    right = motor_limit_duty(right);
+    motor_frame frame;
+    output_build(&frame, left < 0 ? OR_BACKWARDS : OR_FORWARDS, (uint8_t) abs(left),
+                 right < 0 ? OR_BACKWARDS : OR_FORWARDS, (uint8_t) abs(right));
+    output_apply(&frame);
 }
 
 void motor_drive_right(void) {
-    motor_set_left(OR_FORWARDS, SPEED_OUTER);
-    motor_set_right(OR_BACKWARDS, SPEED_INNER);
+    output_apply(&motor_moves[MOVE_RIGHT]);
 }
 
 void motor_drive_forward(void) {
-    motor_set_left(OR_FORWARDS, SPEED_STRAIT);
-    motor_set_right(OR_FORWARDS, SPEED_STRAIT);
+    output_apply(&motor_moves[MOVE_FORWARD]);
+}
+
+void motor_drive_forward_fast(void) {
+    output_apply(&motor_moves[MOVE_FORWARD_FAST]);
+}
+
+void motor_drive_forward_slow(void) {
+    output_apply(&motor_moves[MOVE_FORWARD_SLOW]);
 }
 
 void motor_drive_backward(void) {
-    motor_set_left(OR_BACKWARDS, SPEED_STRAIT);
-    motor_set_right(OR_BACKWARDS, SPEED_STRAIT);
+    output_apply(&motor_moves[MOVE_BACKWARD]);
 }
 
 void motor_drive_backward_smooth(void) {
-    motor_set_left(OR_BACKWARDS, SPEED_BACK_SMOOTH);
-    motor_set_right(OR_BACKWARDS, SPEED_BACK_SMOOTH);
+    output_apply(&motor_moves[MOVE_BACKWARD_SMOOTH]);
 }
 
 void motor_drive_left(void) {
-    motor_set_right(OR_FORWARDS, SPEED_OUTER);
-    motor_set_left(OR_BACKWARDS, SPEED_INNER);
+    output_apply(&motor_moves[MOVE_LEFT]);
 }
 
 void motor_drive_stop(void) {
-    motor_set_left(OR_STOP, SPEED_ZERO);
-    motor_set_right(OR_STOP, SPEED_ZERO);
+    output_apply(&motor_moves[MOVE_STOP]);
 }
 
-direction motor_evaluate_sensors(sensor_state current) {
-    if ((current & SENSOR_CENTER)
-        && ((current & SENSOR_LEFT) == (current & SENSOR_RIGHT))
-        || !(current & SENSOR_LEFT) == !(current & SENSOR_RIGHT)) {
-        return DIR_FORWARD;
+void motor_brake(uint8_t duty) {
+    motor_frame frame;
+    output_build(&frame, OR_BRAKE, duty, OR_BRAKE, duty);
+    output_apply(&frame);
+}
+
+void drive_brake_start(track_state *state, uint16_t time) {
+    if (!state->brake_duty) {
+        return;
     }
-    if (current & SENSOR_RIGHT) {
-        return DIR_RIGHT;
+    state->brake_since = millis;
+    state->brake_time = time;
+}
+
+uint8_t drive_brake_hold(track_state *state) {
+    if (!state->brake_time) {
+        return 0;
     }
-    if (current & SENSOR_LEFT) {
-        return DIR_LEFT;
+    if (millis - state->brake_since >= state->brake_time) {
+        state->brake_time = 0;
+        return 0;
     }
-    return DIR_NONE;
+    motor_brake(state->brake_duty);
+    return 1;
+}
+
+direction motor_evaluate_sensors(sensor_state current) {
+    return drive_table_evaluate(current);
 }
 
 direction motor_calc_direction(
@@ -137,18 +136,7 @@ direction motor_calc_direction(
         direction *last_dir,
         direction *last_simple
 ) {
-    if (current == SENSOR_NONE) {
-        if (last_state == SENSOR_ALL || (last_state & SENSOR_LEFT) == (last_state & SENSOR_RIGHT)) {
-            return *last_simple;
-        }
-        return *last_dir;
-    } else {
-        *last_dir = motor_evaluate_sensors(current);
-        if (*last_dir == SENSOR_RIGHT || *last_dir == SENSOR_LEFT) {
-            *last_simple = *last_dir;
-        }
-        return *last_dir;
-    }
+    return drive_table_direction(current, last_state, last_dir, last_simple);
 }
 
 void drive_move_direction(track_state *state, direction dir) {
@@ -171,11 +159,222 @@ void drive_move_direction(track_state *state, direction dir) {
     state->dir_last = dir;
 }
 
+void pid_init(pid_controller *pid) {
+    pid->kp = PID_KP_DEFAULT;
+    pid->ki = PID_KI_DEFAULT;
+    pid->kd = PID_KD_DEFAULT;
+    pid->base = PID_BASE_DEFAULT;
+    pid_reset(pid);
+}
+
+void pid_reset(pid_controller *pid) {
+    pid->integral = 0;
+    pid->derivative = 0;
+    pid->last_error = 0;
+    pid->last_time = millis;
+}
+
+int16_t pid_update(pid_controller *pid, int16_t error) {
+    int16_t integral = pid->integral + error;
+    if (integral > PID_INTEGRAL_LIMIT) {
+        integral = PID_INTEGRAL_LIMIT;
+    } else if (integral < -PID_INTEGRAL_LIMIT) {
+        integral = -PID_INTEGRAL_LIMIT;
+    }
+    pid->integral = integral;
+    // derivative += (change - derivative) / 2^n, both sides with the fraction bits
+    int16_t change = (error - pid->last_error) * (1 << PID_DERIVATIVE_FRACTION);
+    pid->derivative += (change - pid->derivative) >> PID_DERIVATIVE_SHIFT;
+    pid->last_error = error;
+
+    int32_t output = (int32_t) pid->kp * error
+                     + (int32_t) pid->ki * integral
+                     + (((int32_t) pid->kd * pid->derivative) >> PID_DERIVATIVE_FRACTION);
+    output >>= 8;
+    if (output > 2 * PID_DUTY_MAX) {
+        return 2 * PID_DUTY_MAX;
+    }
+    if (output < -2 * PID_DUTY_MAX) {
+        return -2 * PID_DUTY_MAX;
+    }
+    return (int16_t) output;
+}
+
+/**
+ * @brief Updates the estimator of the offset with the sensors and the current command
+ * @param state Current global state
+ * @param position Measured position of the line
+ */
+static void drive_estimate(track_state *state, const line_position *position) {
+    const motor_frame *command = output_current();
+    estimate_update(&state->estimator, position->offset,
+                    position->confidence >= LINE_CONFIDENCE_MIN,
+                    command->duty_left - command->duty_right, millis);
+}
+
+void drive_follow_pid(track_state *state, segment_class speed) {
+    pid_controller *pid = &state->pid;
+    line_position position;
+    uint8_t period = millis - pid->last_time >= PID_PERIOD_MS;
+    // The estimator follows the line between the periods of the controller as well
+    if (period || state->estimate_lead) {
+        sensor_get_position(&position);
+    }
+    if (state->estimate_lead) {
+        drive_estimate(state, &position);
+    }
+    if (!period) {
+        return;
+    }
+    pid->last_time = millis;
+    int16_t offset = position.offset;
+    if (state->estimate_lead && state->estimator.valid) {
+        offset = estimate_offset(&state->estimator, state->estimate_lead);
+        if (offset > LINE_OFFSET_LOST) {
+            offset = LINE_OFFSET_LOST;
+        } else if (offset < -LINE_OFFSET_LOST) {
+            offset = -LINE_OFFSET_LOST;
+        }
+    }
+    int16_t output = pid_update(pid, offset);
+    int16_t base = pid->base;
+    if (speed == CLASS_STRAIGHT) {
+        base += PID_BOOST;
+    } else if (speed == CLASS_SHARP) {
+        base -= PID_SLOWDOWN;
+    }
+    motor_set_wheels(base + output, base - output);
+    // Only for the ui, which shows the three moves of the sensor logic
+    if (output >= PID_STRAIGHT_BAND) {
+        state->dir_last = DIR_RIGHT;
+    } else if (output <= -PID_STRAIGHT_BAND) {
+        state->dir_last = DIR_LEFT;
+    } else {
+        state->dir_last = DIR_FORWARD;
+    }
+}
+
+/**
+ * @brief Selects the speed on the current part of the track, see @ref secDriSpeed
+ * @param state Current global state
+ * @return Label of the track, #CLASS_GENTLE drives at the normal speed
+ */
+static segment_class drive_select_speed(track_state *state) {
+    // The label is followed even if it does not set the speed, the lap timer takes splits from it
+    segment_class before = state->classifier.label;
+    segment_class label = classify_update(&state->classifier, state->dir_last, millis);
+    if (label != before && label == CLASS_SHARP) {
+        laps_split(SPLIT_SHARP);
+    } else if (label != before && label == CLASS_STRAIGHT) {
+        laps_split(SPLIT_STRAIGHT);
+    }
+    segment_class speed = state->classify ? label : CLASS_GENTLE;
+    if (state->learning && map_is_valid()) {
+        segment_class known = map_is_straight_ahead() ? CLASS_STRAIGHT : CLASS_GENTLE;
+        if (!state->classify || known > speed) {
+            speed = known;
+        }
+    }
+    return speed;
+}
+
+uint8_t drive_recover(track_state *state) {
+    line_recovery *recovery = &state->recovery;
+    if (state->sensor_current != SENSOR_NONE) {
+        recovery->stage = RECOVER_NONE;
+        return 0;
+    }
+    uint32_t now = millis;
+    switch (recovery->stage) {
+        case RECOVER_NONE:
+            laps_split(SPLIT_LOST);
+            recovery->stage = RECOVER_HOLD;
+            recovery->lost_since = now;
+            recovery->stage_since = now;
+            return 0;
+        case RECOVER_HOLD:
+            if (now - recovery->stage_since < RECOVER_HOLD_TIME) {
+                return 0;
+            }
+            recovery->stage = RECOVER_SWEEP;
+            recovery->sweep = 0;
+            recovery->stage_since = now;
+            // The first turn goes to the side the line was seen last
+            if (state->dir_last == DIR_LEFT || state->dir_last == DIR_RIGHT) {
+                recovery->side = state->dir_last;
+            } else {
+                recovery->side = state->dir_last_simple == DIR_LEFT ? DIR_LEFT : DIR_RIGHT;
+            }
+            break;
+        case RECOVER_SWEEP:
+            if (now - recovery->lost_since >= RECOVER_BUDGET_TIME) {
+                recovery->stage = RECOVER_FAILED;
+                motor_drive_stop();
+                state->dir_last = DIR_NONE;
+                state->action = AC_PAUSE;
+                usart_print_pretty_P(PSTR("Lost the line and could not find it again, stopped. "
+                                          "Place me on the line and send P to go on."));
+                return 1;
+            }
+            if (now - recovery->stage_since >= (uint32_t) RECOVER_SWEEP_TIME
+                                                 * (recovery->sweep + 1)) {
+                recovery->sweep++;
+                recovery->stage_since = now;
+            }
+            break;
+        default:
+            motor_drive_stop();
+            return 1;
+    }
+    // Every turn goes to the other side than the one before
+    direction turn = recovery->side;
+    if (recovery->sweep & 1) {
+        turn = turn == DIR_LEFT ? DIR_RIGHT : DIR_LEFT;
+    }
+    if (turn == DIR_LEFT) {
+        motor_set_wheels(-RECOVER_SWEEP_DUTY, RECOVER_SWEEP_DUTY);
+    } else {
+        motor_set_wheels(RECOVER_SWEEP_DUTY, -RECOVER_SWEEP_DUTY);
+    }
+    state->dir_last = turn;
+    return 1;
+}
+
 void drive_apply(track_state *state) {
+    map_update(state->dir_last);
+    if (drive_recover(state)) {
+        return;
+    }
+    segment_class speed = drive_select_speed(state);
+    if (state->recovery.stage == RECOVER_HOLD) {
+        speed = CLASS_SHARP;
+    }
+    // A higher label is a slower one, brake shortly instead of coasting into the curve. The hold
+    // after a line loss is no curve, braking there would only stop the robot away from the line
+    if (speed > state->speed_last && state->recovery.stage == RECOVER_NONE) {
+        drive_brake_start(state, BRAKE_CURVE_TIME);
+    }
+    state->speed_last = speed;
+    if (drive_brake_hold(state)) {
+        return;
+    }
+    if (state->logic == DRIVE_LOGIC_PID) {
+        drive_follow_pid(state, speed);
+        return;
+    }
     direction dir = motor_calc_direction(state->sensor_current,
                                          SENSOR_RIGHT,
                                          &(state->dir_last_valid),
                                          &(state->dir_last_simple));
+    if (dir == DIR_FORWARD && speed != CLASS_GENTLE) {
+        if (speed == CLASS_STRAIGHT) {
+            motor_drive_forward_fast();
+        } else {
+            motor_drive_forward_slow();
+        }
+        state->dir_last = dir;
+        return;
+    }
     drive_move_direction(state, dir);
 }
 
@@ -195,15 +394,19 @@ void drive_home(track_state *state) {
             drive_move_direction(state, DIR_BACK);
             // Stop if on starting field
             if (state->sensor_current == SENSOR_ALL) {
+                drive_brake_start(state, BRAKE_STOP_TIME);
                 state->drive = DS_POST_DRIVE;
             }
             break;
         case DS_CHECK_START:
         case DS_POST_DRIVE:
+            if (drive_brake_hold(state)) {
+                break;
+            }
             motor_drive_stop();
-            usart_print_pretty(
+            usart_print_pretty_P(PSTR(
                     "I just arrived at home. Resetting NOW! Take care of my messages when I'm"
-                    "back...");
+                    "back..."));
             util_reset_instant();
             //Never reached
             break;
@@ -213,17 +416,103 @@ void drive_home(track_state *state) {
 }
 
 void drive_manual(track_state *state) {
-    if (timers_check_state(state, COUNTER_1_HZ)
-        && (state->manual_dir || state->manual_dir_last)) {
-        if (state->manual_dir_last) {
+    if (state->manual_dir != DIR_NONE && millis - state->manual_time >= MANUAL_DEADMAN_TIME) {
+        // The commands stopped coming, the key was released or the connection is gone
+        state->manual_dir = DIR_NONE;
+    }
+    int16_t duty = manual_duties[state->manual_level];
+    switch (state->manual_dir) {
+        case DIR_FORWARD:
+            motor_set_wheels(duty, duty);
+            break;
+        case DIR_BACK:
+            motor_set_wheels(-duty, -duty);
+            break;
+        case DIR_LEFT:
+            motor_set_wheels(-duty, duty);
+            break;
+        case DIR_RIGHT:
+            motor_set_wheels(duty, -duty);
+            break;
+        default:
             motor_drive_stop();
-            state->manual_dir_last = 0;
-        } else {
-            drive_move_direction(state, state->manual_dir);
-            state->manual_dir = DIR_NONE;
-            state->manual_dir_last = 1;
+            break;
+    }
+    state->dir_last = state->manual_dir;
+}
+
+void drive_script(track_state *state) {
+    uint32_t elapsed;
+    if (!script_take_done(&elapsed)) {
+        return;
+    }
+    state->action = AC_WAIT;
+    char s[sizeof("Script done: 16 steps, planned 4294967295 ms, measured 4294967295 ms")];
+    sprintf_P(s, PSTR("Script done: %u steps, planned %lu ms, measured %lu ms"),
+              script_get_length(), script_get_planned(), elapsed);
+    usart_print_pretty(s);
+}
+
+void drive_calibrate(track_state *state) {
+    uint32_t elapsed = millis - state->calib_start;
+    calib_sample();
+    if (elapsed < DRIVE_CALIB_SWEEP_TIME / 4
+        || (elapsed >= DRIVE_CALIB_SWEEP_TIME * 3 / 4 && elapsed < DRIVE_CALIB_SWEEP_TIME)) {
+        motor_set_wheels(-SPEED_CALIBRATE, SPEED_CALIBRATE);
+        state->dir_last = DIR_LEFT;
+        return;
+    }
+    if (elapsed < DRIVE_CALIB_SWEEP_TIME) {
+        motor_set_wheels(SPEED_CALIBRATE, -SPEED_CALIBRATE);
+        state->dir_last = DIR_RIGHT;
+        return;
+    }
+    motor_drive_stop();
+    state->dir_last = DIR_NONE;
+    state->action = AC_WAIT;
+    if (!calib_finish()) {
+        usart_print_pretty_P(PSTR("Calibration failed, not every sensor saw the line. "
+                                  "Keeping the old thresholds."));
+        return;
+    }
+    for (uint8_t channel = 0; channel < CALIB_SENSOR_AMOUNT; ++channel) {
+        char s[sizeof("Sensor 0: background 1023, line 1023, lower 1023, upper 1023")];
+        sprintf_P(s, PSTR("Sensor %d: background %u, line %u, lower %u, upper %u"), channel,
+                  calib_current.background[channel], calib_current.line[channel],
+                  calib_current.lower[channel], calib_current.upper[channel]);
+        usart_println(s);
+    }
+    usart_print_pretty_P(PSTR("Calibration done and saved."));
+}
+
+uint8_t motor_find_min_duty(uint8_t left) {
+    line_position start;
+    line_position current;
+    sensor_get_position(&start);
+    uint8_t found = 0;
+    for (uint16_t duty = MOTOR_TEST_DUTY_STEP; duty <= OUTPUT_DUTY_FULL && !found;
+         duty += MOTOR_TEST_DUTY_STEP) {
+        motor_set_wheels(left ? -(int16_t) duty : (int16_t) duty,
+                         left ? (int16_t) duty : -(int16_t) duty);
+        uint32_t since = millis;
+        while (millis - since < MOTOR_TEST_STEP_TIME) {
+            sensor_get_position(&current);
+            if (abs(current.offset - start.offset) >= MOTOR_TEST_OFFSET) {
+                found = (uint8_t) duty;
+                break;
+            }
         }
     }
+    motor_drive_stop();
+    return found;
+}
+
+/**
+ * @brief Ends the current round of the lap timer, which sends its time, and of the map
+ */
+static void drive_end_lap(void) {
+    laps_end();
+    map_end_lap();
 }
 
 void drive_run(track_state *state) {
@@ -232,34 +521,45 @@ void drive_run(track_state *state) {
             //When on start field begin first round
             if (state->pos == POS_START_FIELD) {
                 state->drive = DS_ZERO_ROUND;
-                usart_print_pretty(
+                usart_print_pretty_P(PSTR(
                         "Here I go again on my own, going down the only round I've ever known..."
-                );
+                ));
             }
             break;
         case DS_ZERO_ROUND: //Fallthrough
         case DS_FIRST_ROUND: //Fallthrough
         case DS_SECOND_ROUND: //Fallthrough
         case DS_THIRD_ROUND: //Fallthrough
-            if (timers_check_state(state, COUNTER_12_HZ) &&
-                state->pos == POS_TRACK && state->last_pos == POS_START_FIELD) {
+            // Only true in the cycle the robot left the start field
+            if (state->pos == POS_TRACK && state->last_pos == POS_START_FIELD) {
                 switch (state->drive) {
                     case DS_ZERO_ROUND:
                         state->drive = DS_FIRST_ROUND;
+                        map_begin_lap(1);
+                        laps_begin(1);
+                        state->speed_last = CLASS_GENTLE;
                         break;
                     case DS_FIRST_ROUND:
-                        usart_print_pretty("YEAH, done round 1, going for round 2/3");
+                        usart_print_pretty_P(PSTR("YEAH, done round 1, going for round 2/3"));
+                        drive_end_lap();
                         state->drive = DS_SECOND_ROUND;
+                        map_begin_lap(0);
+                        laps_begin(2);
                         break;
                     case DS_SECOND_ROUND:
-                        usart_print_pretty("YEAH YEAH, done round 2, going for round 3/3");
+                        usart_print_pretty_P(PSTR("YEAH YEAH, done round 2, going for round 3/3"));
+                        drive_end_lap();
                         state->drive = DS_THIRD_ROUND;
+                        map_begin_lap(0);
+                        laps_begin(3);
                         break;
                     case DS_THIRD_ROUND:
-                        usart_print_pretty(
+                        drive_end_lap();
+                        laps_send_summary();
+                        usart_print_pretty_P(PSTR(
                                 "YEAH YEAH YEAH , I really did it my way. ... And what's my "
                                 "purpose\n and the general sense of my further life now?"
-                                " Type ? for help");
+                                " Type ? for help"));
                         state->drive = DS_BACKWARDS;
                         break;
                     default:
@@ -272,10 +572,14 @@ void drive_run(track_state *state) {
         case DS_BACKWARDS:
             motor_drive_backward_smooth();
             if (state->sensor_current == SENSOR_ALL) {
+                drive_brake_start(state, BRAKE_STOP_TIME);
                 state->drive = DS_POST_DRIVE;
             }
             break;
         case DS_POST_DRIVE:
+            if (drive_brake_hold(state)) {
+                break;
+            }
             motor_drive_stop();
             state->action = AC_RESET;
             break;
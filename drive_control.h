@@ -40,7 +40,79 @@
  * of the motors. We use a timer (in this case @ref secTimer0) to control how long and often a motor
  * receives voltage. We realize this through enable and disable the pin if the compare value of the
  * timer exceeds or is equal to the defined compare value of one of the motors. We so the pin will
- * change from 1 to 0. In the default position the pin is set to 1, i.e enabled.
+ * change from 1 to 0. In the default position the pin is set to 1, i.e enabled. The registers are
+ * written by the @ref output "motor output module", which skips a command if it did not change.
+ *
+ * @section secDriPid PID Controller
+ * The default logic only knows three moves, it picks one of them from the state of the sensors and
+ * lets the robot zig-zag along the line. With #DRIVE_LOGIC_PID the offset of the line
+ * (see @ref secLinePos) is the error of a pid controller instead, which runs every #PID_PERIOD_MS
+ * milliseconds and only uses integer arithmetic. Its output u is added to the base duty of the
+ * left and subtracted from the base duty of the right wheel, so the speed of the wheels changes
+ * continuously and a wheel turns backwards if its duty gets negative.
+ * @f[ u = K_p e + K_i \sum e + K_d \Delta e @f]
+ * The sum of the errors is limited to #PID_INTEGRAL_LIMIT, so it can not wind up while the line is
+ * lost, and the change of the error is smoothed by a first order filter, as the offset moves in
+ * steps when the line passes a sensor. The gains and the base duty can be changed at runtime, so
+ * both logics can be compared on the same track. If a lead is set, the error is not the measured
+ * offset but the offset the @ref estimate "estimator" predicts that many milliseconds ahead, so
+ * the controller steers into a curve before the line left the center sensor.
+ * @sa #drive_follow_pid
+ *
+ * @section secDriSpeed Speed Scheduling
+ * The speed of the robot on the current part of the track is one of the labels of the
+ * @ref classify "classifier", #CLASS_STRAIGHT drives faster than on a plain line, #CLASS_SHARP
+ * slower. If the classifier is switched on, it sets the label live from the steering. If a
+ * @ref map "map" of the track was learned, the robot only drives faster if the map also knows a
+ * straight ahead, so the slower of both labels is used. The sensor logic drives forward with
+ * #SPEED_FAST, #SPEED_STRAIT or #SPEED_SLOW, the pid controller adds #PID_BOOST to its base duty
+ * or subtracts #PID_SLOWDOWN from it.
+ * @sa #drive_apply
+ *
+ * @section secDriLost Lost Line
+ * If no sensor sees the line anymore, the logic alone would keep turning into the last direction
+ * forever, so losing the line at a high speed ends in a spin or the robot runs away. Instead the
+ * robot searches the line in stages with a fixed budget and goes back to following it as soon as
+ * any sensor sees it again.
+ * 1. For #RECOVER_HOLD_TIME milliseconds the logic keeps the last heading at the speed of a sharp
+ *    curve, which is enough for a gap in the line or a curve that was cut.
+ * 2. Then the robot turns on the spot, first to the side the line was seen last. Every turn takes
+ *    #RECOVER_SWEEP_TIME milliseconds longer than the one before into the other direction, so the
+ *    searched angle grows on both sides.
+ * 3. After #RECOVER_BUDGET_TIME milliseconds without the line the robot stops, pauses the action
+ *    and reports the loss in the state updates of #state_send_update. Placed back on the line, it
+ *    continues with `P`.
+ * @sa #drive_recover
+ *
+ * @section secDriManual Manual Control
+ * A direction key received in the manual mode is applied in the next cycle of the run loop, and
+ * the robot keeps driving into that direction as long as the key is received again within
+ * #MANUAL_DEADMAN_TIME milliseconds. The user interface repeats the key while it is held, so the
+ * robot stops shortly after the key was released or the connection broke down. The keys `1` to
+ * `3` select the duty of the wheels, the turns are on the spot with the same duty.
+ * @sa #drive_manual
+ *
+ * @section secDriBrake Active Brake
+ * Taking away the duty only lets the wheels coast, so the robot enters a curve faster than the
+ * speed scheduling wants and rolls over the start field when it stops at home. If a brake duty is
+ * set with `=K`, the robot shorts both motors with #motor_brake instead, see @ref secOutBrake.
+ * Whenever the speed scheduling switches to a slower label it brakes for #BRAKE_CURVE_TIME
+ * milliseconds before it follows the line again, and at home it brakes for #BRAKE_STOP_TIME
+ * milliseconds before the motors are switched off. A line loss does not brake, the sharp label
+ * of its recovery is taken over without it. `=K0` switches the brake off.
+ * @sa #drive_brake_start
+ *
+ * @section secDriTable Decision Table
+ * The direction of the default logic only depends on the current and the last state of the
+ * sensors and on the last two directions, so there are only 8 * 8 * 5 * 5 possible inputs. The
+ * readable rules in drive_rules.c are not part of the firmware, tools/drive_table_gen.c runs them
+ * on the host for every input while building and writes their results into drive_table.c. Each
+ * entry of the table in the flash packs the direction to drive, the new last direction and if the
+ * last simple direction changes into one byte, so a decision is one read of the flash without any
+ * branch and takes the same time for every input. Before the table is compiled,
+ * tools/drive_table_check.c compares the lookup with the rules for every input and stops the build
+ * on the first difference.
+ * @sa #drive_table_direction
  */
 #ifndef MOTOR_DRIVE
 #define MOTOR_DRIVE
@@ -48,77 +120,72 @@
 #include <avr/io.h>
 #include "timers.h"
 #include "robot_sensor.h"
+#include "sensor_calib.h"
 #include "usart.h"
 #include "utility.h"
+#include "drive_table.h"
+#include "motor_output.h"
+#include "track_map.h"
+#include "track_laps.h"
+#include "drive_script.h"
 
-// Direction Register = DR
-// Input Register = IR
-// Output Register = OR
-
-//IN1 Left Forward
-/** @brief Direction Register of the left wheel forward */
-#define DR_M_LF DDRD
-/** @brief Direction Pin of the left wheel forward */
-#define DP_M_LF DD7
-/** @brief Output Register of the left wheel forward */
-#define OR_M_LF PORTD
-/** @brief Output Pin of the left wheel forward */
-#define OP_M_LF PD7
-
-//IN2 Left Backward
-/** @brief Direction Register of the left wheel backward */
-#define DR_M_LB DDRB
-/** @brief Direction Pin of the left wheel backward */
-#define DP_M_LB DD0
-/** @brief Output Register of the left wheel backward */
-#define OR_M_LB PORTB
-/** @brief Output Pin of the left wheel backward */
-#define OP_M_LB PB0
-
-//IN4 Right Forward
-/** @brief Direction Register of the right wheel forward */
-#define DR_M_RF DDRB
-/** @brief Direction Pin of the right wheel forward */
-#define DP_M_RF DD3
-/** @brief Output Register of the right wheel forward */
-#define OR_M_RF PORTB
-/** @brief Output Pin of the right wheel forward */
-#define OP_M_RF PB3
-
-//IN3 Right Backward
-/** @brief Direction Register of the right wheel backward */
-#define DR_M_RB DDRB
-/** @brief Direction Pin of the right wheel backward */
-#define DP_M_RB DD1
-/** @brief Output Register of the right wheel backward */
-#define OR_M_RB PORTB
-/** @brief Output Pin of the right wheel backward */
-#define OP_M_RB PB1
-
-/** @brief First of the two data direction registries used by this module*/
-#define DR_MOTOR_FIRST DDRD
-/** @brief Second of the two data direction registries used by this module*/
-#define DR_MOTOR_SECOND DDRB
-
-// Left Enable
-/** @brief Direction Register of the left motor speed */
-#define DR_M_LE DDRD
-/** @brief Direction Pin of the left motor speed */
-#define DP_M_LE DD5
-/** @brief Output Register of the left motor speed */
-#define OR_M_LE PORTD
-/** @brief Output Pin of the left motor speed  */
-#define OP_M_LE PD5
-
-// Right Enable Motor
-/** @brief Direction Register of the right motor speed */
-#define DR_M_RE DDRD
-/** @brief Direction Pin of the right motor speed */
-#define DP_M_RE DD6
-/** @brief Output Register of the right motor speed */
-#define OR_M_RE PORTD
-/** @brief Output Pin of the right motor speed  */
-#define OP_M_RE PD6
+/**
+ * @brief Duration of the sweep over the line while calibrating in milliseconds
+ * @details The robot turns left for a quarter, right for the half and left for the last quarter of
+ * the time, so it ends up where it started.
+ */
+#define DRIVE_CALIB_SWEEP_TIME 4000
+
+/** @brief Period of the pid controller in milliseconds */
+#define PID_PERIOD_MS 5
+/** @brief Default proportional gain, 8 fraction bits */
+#define PID_KP_DEFAULT 96
+/** @brief Default integral gain, 8 fraction bits */
+#define PID_KI_DEFAULT 2
+/** @brief Default derivative gain, 8 fraction bits */
+#define PID_KD_DEFAULT 384
+/** @brief Default duty of both wheels if the line is centered */
+#define PID_BASE_DEFAULT 150
+/** @brief Limit of the sum of the errors in both directions */
+#define PID_INTEGRAL_LIMIT 8192
+/** @brief Smoothing of the derivative, every period moves it by 1/2^n of the difference */
+#define PID_DERIVATIVE_SHIFT 2
+/** @brief Fraction bits of the filtered derivative */
+#define PID_DERIVATIVE_FRACTION 4
+/** @brief Largest duty of a wheel */
+#define PID_DUTY_MAX 255
+/** @brief Difference of the duty of the wheels below which the robot counts as driving straight */
+#define PID_STRAIGHT_BAND 32
+/** @brief Increase of the base duty of the pid controller on a straight */
+#define PID_BOOST 60
+/** @brief Decrease of the base duty of the pid controller in a sharp curve */
+#define PID_SLOWDOWN 40
+
+/** @brief Time in milliseconds the last heading is kept after the line was lost */
+#define RECOVER_HOLD_TIME 150
+/** @brief Length of the first turn of the sweep, every turn takes that much longer */
+#define RECOVER_SWEEP_TIME 120
+/** @brief Duty of both wheels while turning on the spot to search the line */
+#define RECOVER_SWEEP_DUTY 130
+/** @brief Time in milliseconds after the line was lost that the robot gives up and stops */
+#define RECOVER_BUDGET_TIME 2500
+/** @brief Time in milliseconds the manual control keeps driving after the last received key */
+#define MANUAL_DEADMAN_TIME 150
+/** @brief Amount of speed levels of the manual control */
+#define MANUAL_LEVEL_AMOUNT 3
+/** @brief Speed level the manual control starts with, the duty of #SPEED_STRAIT */
+#define MANUAL_LEVEL_DEFAULT 1
+/** @brief Time in milliseconds the robot brakes when the speed scheduling gets slower */
+#define BRAKE_CURVE_TIME 40
+/** @brief Time in milliseconds the robot brakes before it stops at home */
+#define BRAKE_STOP_TIME 150
+
+/** @brief Increase of the duty while searching the smallest duty that turns the wheels */
+#define MOTOR_TEST_DUTY_STEP 2
+/** @brief Time in milliseconds every duty is held while searching the smallest duty */
+#define MOTOR_TEST_STEP_TIME 30
+/** @brief Change of the line offset that counts as a movement of the robot */
+#define MOTOR_TEST_OFFSET 24
 
 /** @brief Amount of cached states */
 #define BRICK_CACHED_AMOUNT 4
@@ -128,22 +195,46 @@
 #define BRICK_THRESHOLD 2
 
 /**
- * @brief Possible directions of the two motors.
+ * @brief Fixed moves of the robot, their frames are built once by #motor_init
  */
 typedef enum {
-/**
-* @brief Move motor forward
-*/
-    OR_FORWARDS,
-/**
- * @brief Move motor backward
- */
-    OR_BACKWARDS,
-/**
- * @brief Stop the motor movement
- */
-    OR_STOP
-} orientation;
+    /**
+     * @brief Both wheels stand still
+     */
+    MOVE_STOP,
+    /**
+     * @brief Both wheels forward with #SPEED_STRAIT
+     */
+    MOVE_FORWARD,
+    /**
+     * @brief Both wheels forward with #SPEED_FAST
+     */
+    MOVE_FORWARD_FAST,
+    /**
+     * @brief Both wheels forward with #SPEED_SLOW
+     */
+    MOVE_FORWARD_SLOW,
+    /**
+     * @brief Both wheels backwards with #SPEED_STRAIT
+     */
+    MOVE_BACKWARD,
+    /**
+     * @brief Both wheels backwards with #SPEED_BACK_SMOOTH
+     */
+    MOVE_BACKWARD_SMOOTH,
+    /**
+     * @brief Turn on the spot to the left
+     */
+    MOVE_LEFT,
+    /**
+     * @brief Turn on the spot to the right
+     */
+    MOVE_RIGHT,
+    /**
+     * @brief Amount of fixed moves
+     */
+    MOVE_AMOUNT
+} motor_move;
 
 /**
  * @brief Defines the possible speed values of the motors.
@@ -163,6 +254,18 @@ typedef enum {
     SPEED_STRAIT = 125,
     SPEED_BACK_SMOOTH = 90,
 /**
+* @brief Speed on a straight, see @ref secDriSpeed
+*/
+    SPEED_FAST = 190,
+/**
+* @brief Speed forward in a sharp curve, see @ref secDriSpeed
+*/
+    SPEED_SLOW = 100,
+/**
+* @brief Speed of both wheels while turning on the spot to calibrate the sensors
+*/
+    SPEED_CALIBRATE = 100,
+/**
 * @brief Speed of the outer wheel
 */
     SPEED_OUTER = 220
@@ -174,41 +277,36 @@ typedef enum {
 void motor_clear(void);
 
 /**
- * @brief Initialises the drive module
+ * @brief Initialises the drive module and builds the frames of the fixed moves
  */
 void motor_init(void);
 
 /**
- * @brief Defines speed of the wheels on one side.
- *
- * Defines speed of the wheels by defining how often a they are turned on,
- * a higher value results in an faster wheel.
- *
- * @pre Call #timers_setup_timer_0() before usage!
- * @param pin PD5/PD6 for left/right motor cycle
- * @param value Defines speed of the wheels. (0 - 255 = 0% - 100%)
- */
-void motor_set_duty(uint8_t pin, speed_value value);
-
-/**
- * @brief Sets the speed of the left motor.
+ * @brief Sets the speed of the left motor, the right one keeps its command.
  *
  * @param dir Direction of the motor motion
  * @param speed_state Speed of the motor.
- * @sa motor_set_duty
+ * @sa output_set_left
  *
  */
 void motor_set_left(orientation dir, speed_value speed_state);
 
 /**
- * @brief Sets the speed of the right motor.
+ * @brief Sets the speed of the right motor, the left one keeps its command.
  *
  * @param dir Direction of the motor motion
  * @param speed_state Speed of the motor.
- * @sa motor_set_duty
+ * @sa output_set_right
  */
 void motor_set_right(orientation dir, speed_value speed_state);
 
+/**
+ * @brief Sets the duty of both wheels, negative values turn a wheel backwards
+ * @param left Duty of the left wheel, limited to plus minus #PID_DUTY_MAX
+ * @param right Duty of the right wheel, limited to plus minus #PID_DUTY_MAX
+ */
+void motor_set_wheels(int16_t left, int16_t right);
+
 /**
  * @brief Sets the values to drive the robot to the left
  */
@@ -224,6 +322,16 @@ void motor_drive_right(void);
  */
 void motor_drive_forward(void);
 
+/**
+ * @brief Sets the values to drive the robot forward on a straight
+ */
+void motor_drive_forward_fast(void);
+
+/**
+ * @brief Sets the values to drive the robot forward in a sharp curve
+ */
+void motor_drive_forward_slow(void);
+
 /**
  * @brief Sets the values to drive the robot to backward
  */
@@ -241,8 +349,30 @@ void motor_drive_backward_smooth(void);
  */
 void motor_drive_stop(void);
 
+/**
+ * @brief Brakes both wheels actively instead of letting them coast, see @ref secOutBrake
+ * @param duty Strength of the brake, 0 to #OUTPUT_DUTY_FULL
+ */
+void motor_brake(uint8_t duty);
+
+/**
+ * @brief Starts braking for a time, if a brake duty is set in track_state#brake_duty
+ * @param state Current global state
+ * @param time Time in milliseconds to brake
+ */
+void drive_brake_start(track_state *state, uint16_t time);
+
+/**
+ * @brief Keeps braking while the time of #drive_brake_start did not pass yet
+ * @param state Current global state
+ * @retval 1 if the robot brakes and nothing else may drive the wheels
+ * @retval 0 otherwise
+ */
+uint8_t drive_brake_hold(track_state *state);
+
 /**
  * @brief Reads sensor input and evaluates the direction that the robot has to drive.
+ * @details Looked up in the @ref secDriTable "decision table".
  * @param current Current sensor state
  */
 direction motor_evaluate_sensors(sensor_state current);
@@ -254,12 +384,55 @@ direction motor_evaluate_sensors(sensor_state current);
  * @param last_state Sensor state in last cycle
  * @param last_dir Last direction driven, that was not #DIR_NONE
  * @param last_simple Last direction driven, that was #DIR_LEFT or #DIR_RIGHT
+ * @details Looked up in the @ref secDriTable "decision table".
  */
 direction motor_calc_direction(sensor_state current, sensor_state last_state,
                                direction *last_dir, direction *last_simple);
 
+/**
+ * @brief Sets the default gains and base duty and resets the controller
+ * @param pid Controller
+ */
+void pid_init(pid_controller *pid);
+
+/**
+ * @brief Clears the integral, the derivative and the last error of the controller
+ * @param pid Controller
+ */
+void pid_reset(pid_controller *pid);
+
+/**
+ * @brief Runs one period of the controller
+ * @param pid Controller
+ * @param error Offset of the line, positive if it is on the right
+ * @return Difference of the duty of the wheels, positive to turn right
+ */
+int16_t pid_update(pid_controller *pid, int16_t error);
+
+/**
+ * @brief Follows the line with the pid controller
+ * @details Runs the controller every #PID_PERIOD_MS, the wheels keep their duty in between.
+ *
+ * @param state Current global state
+ * @param speed Label of the track that sets the base duty, see @ref secDriSpeed
+ */
+void drive_follow_pid(track_state *state, segment_class speed);
+
+/**
+ * @brief Searches the line after it got lost, see @ref secDriLost
+ * @details Called instead of the logic while no sensor sees the line. Returns without driving in
+ * the first stage, so the logic keeps the heading at a lower speed.
+ *
+ * @param state Current global state
+ * @retval 1 if the search drove the wheels
+ * @retval 0 if the logic should drive
+ */
+uint8_t drive_recover(track_state *state);
+
 /**
  * @brief Perform driving of the robot
+ * @details Uses the logic that is selected in track_state#logic, at the speed that is selected by
+ * the @ref secDriSpeed "speed scheduling". Searches the line if it got lost.
  *
  * @param state Current global state
  */
@@ -283,11 +456,40 @@ void drive_home(track_state *state);
 
 /**
  * @brief Manual drive, controlled by the serial
+ * @details Called every cycle, drives until no key was received for #MANUAL_DEADMAN_TIME, see
+ * @ref secDriManual.
  *
  * @param state Current state
  */
 void drive_manual(track_state *state);
 
+/**
+ * @brief Waits for the end of the maneuver script and reports it
+ * @details The steps are applied by the interrupt of timer 1, see @ref script. Ends the action
+ * after the last step and prints the planned and the measured time.
+ *
+ * @param state Current state
+ */
+void drive_script(track_state *state);
+
+/**
+ * @brief Sweeps the sensors over the line and background to calibrate them
+ * @details Ends the action after #DRIVE_CALIB_SWEEP_TIME and prints the result.
+ *
+ * @param state Current state
+ */
+void drive_calibrate(track_state *state);
+
+/**
+ * @brief Turns the robot on the spot with a slowly rising duty until the line moves below it
+ * @details Blocks until the robot moved or the full duty was reached and stops the wheels
+ * afterwards. The robot has to stand over the line and the ramp should be off, otherwise the duty
+ * lags behind.
+ * @param left If the robot turns to the left, otherwise to the right
+ * @return Smallest duty that turned the robot, 0 if it did not move at all
+ */
+uint8_t motor_find_min_duty(uint8_t left);
+
 /**
  * @brief Performance the driving action
  *
@@ -0,0 +1,36 @@
+#include "drive_rules.h"
+
+direction rules_evaluate_sensors(sensor_state current) {
+    if ((current & SENSOR_CENTER)
+        && ((current & SENSOR_LEFT) == (current & SENSOR_RIGHT))
+        || !(current & SENSOR_LEFT) == !(current & SENSOR_RIGHT)) {
+        return DIR_FORWARD;
+    }
+    if (current & SENSOR_RIGHT) {
+        return DIR_RIGHT;
+    }
+    if (current & SENSOR_LEFT) {
+        return DIR_LEFT;
+    }
+    return DIR_NONE;
+}
+
+direction rules_calc_direction(
+        sensor_state current,
+        sensor_state last_state,
+        direction *last_dir,
+        direction *last_simple
+) {
+    if (current == SENSOR_NONE) {
+        if (last_state == SENSOR_ALL || (last_state & SENSOR_LEFT) == (last_state & SENSOR_RIGHT)) {
+            return *last_simple;
+        }
+        return *last_dir;
+    } else {
+        *last_dir = rules_evaluate_sensors(current);
+        if (*last_dir == SENSOR_RIGHT || *last_dir == SENSOR_LEFT) {
+            *last_simple = *last_dir;
+        }
+        return *last_dir;
+    }
+}
@@ -0,0 +1,37 @@
+/**
+ * @file
+ * @author Larson Schneider
+ * @date 17.10.2026
+ * @brief Rules that select the direction to drive from the state of the sensors
+ * @version 0.1
+ * @copyright MIT License.
+ *
+ * This module contains the decision logic of the line following in its readable form. It is not
+ * linked into the firmware, the host generator builds the @ref secDriTable "decision table" from
+ * it and the equivalence check compares the table against it.
+ */
+#ifndef DRIVE_RULES_H
+#define DRIVE_RULES_H
+
+#include "robot_types.h"
+
+/**
+ * @brief Reads sensor input and evaluates the direction that the robot has to drive.
+ * @param current Current sensor state
+ * @return Direction to drive
+ */
+direction rules_evaluate_sensors(sensor_state current);
+
+/**
+ * @brief Selects the direction to drive based on the current sensor state and the last driven
+ * direction.
+ * @param current Current sensor state
+ * @param last_state Sensor state in last cycle
+ * @param last_dir Last direction driven, that was not #DIR_NONE
+ * @param last_simple Last direction driven, that was #DIR_LEFT or #DIR_RIGHT
+ * @return Direction to drive
+ */
+direction rules_calc_direction(sensor_state current, sensor_state last_state,
+                               direction *last_dir, direction *last_simple);
+
+#endif
@@ -0,0 +1,143 @@
+#include "drive_script.h"
+
+/**
+ * @brief Steps of the stored script
+ */
+static script_step script_steps[SCRIPT_STEP_AMOUNT];
+/**
+ * @brief Amount of stored steps
+ */
+static uint8_t script_length = 0;
+/**
+ * @brief Index of the step that runs
+ */
+static volatile uint8_t script_index = 0;
+/**
+ * @brief Milliseconds the current step still takes
+ */
+static volatile uint16_t script_remaining = 0;
+/**
+ * @brief Set while a script runs
+ */
+static volatile uint8_t script_running = 0;
+/**
+ * @brief Set once the last step is done, until it was taken by #script_take_done
+ */
+static volatile uint8_t script_done = 0;
+/**
+ * @brief Time in milliseconds the script was started
+ */
+static uint32_t script_start_time = 0;
+/**
+ * @brief Time in milliseconds the last step was done
+ */
+static volatile uint32_t script_end_time = 0;
+
+/**
+ * @brief Step that stops both wheels after the last step of the script
+ */
+static const script_step script_end = {DIR_NONE, 0, 0};
+
+/**
+ * @brief Writes the move of a step to the wheels
+ * @param step Step to drive
+ */
+static void script_apply(const script_step *step) {
+    orientation left = OR_FORWARDS;
+    orientation right = OR_FORWARDS;
+    switch (step->dir) {
+        case DIR_FORWARD:
+            break;
+        case DIR_BACK:
+            left = OR_BACKWARDS;
+            right = OR_BACKWARDS;
+            break;
+        case DIR_LEFT:
+            left = OR_BACKWARDS;
+            break;
+        case DIR_RIGHT:
+            right = OR_BACKWARDS;
+            break;
+        default:
+            left = OR_STOP;
+            right = OR_STOP;
+            break;
+    }
+    motor_frame frame;
+    output_build(&frame, left, step->duty, right, step->duty);
+    output_apply(&frame);
+}
+
+void script_clear(void) {
+    script_stop();
+    script_length = 0;
+}
+
+uint8_t script_add(direction dir, int16_t duty, int16_t duration) {
+    if (script_length >= SCRIPT_STEP_AMOUNT || duty < 0 || duty > OUTPUT_DUTY_FULL
+        || duration <= 0 || duration > SCRIPT_DURATION_MAX) {
+        return 0;
+    }
+    script_step *step = &script_steps[script_length++];
+    step->dir = dir;
+    step->duty = (uint8_t) duty;
+    step->duration = (uint16_t) duration;
+    return 1;
+}
+
+uint8_t script_get_length(void) {
+    return script_length;
+}
+
+uint32_t script_get_planned(void) {
+    uint32_t planned = 0;
+    for (uint8_t i = 0; i < script_length; ++i) {
+        planned += script_steps[i].duration;
+    }
+    return planned;
+}
+
+uint8_t script_start(void) {
+    if (!script_length) {
+        return 0;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        script_index = 0;
+        script_remaining = script_steps[0].duration;
+        script_done = 0;
+        script_start_time = millis;
+        script_apply(&script_steps[0]);
+        script_running = 1;
+    }
+    return 1;
+}
+
+void script_stop(void) {
+    script_running = 0;
+}
+
+void script_tick(void) {
+    if (!script_running || --script_remaining) {
+        return;
+    }
+    uint8_t index = script_index + 1;
+    if (index >= script_length) {
+        script_apply(&script_end);
+        script_running = 0;
+        script_end_time = millis;
+        script_done = 1;
+        return;
+    }
+    script_index = index;
+    script_remaining = script_steps[index].duration;
+    script_apply(&script_steps[index]);
+}
+
+uint8_t script_take_done(uint32_t *elapsed) {
+    if (!script_done) {
+        return 0;
+    }
+    script_done = 0;
+    *elapsed = script_end_time - script_start_time;
+    return 1;
+}
@@ -0,0 +1,118 @@
+/**
+ * @file
+ * @author Larson Schneider
+ * @date 17.10.2026
+ * @brief Runs a short uploaded sequence of moves on the timebase of the robot
+ * @version 0.1
+ * @copyright MIT License.
+ *
+ * This module stores a script of moves that was sent over the serial connection and runs it step
+ * by step from the millisecond interrupt of timer 1, independent of the serial link.
+ */
+/**
+ * @page script Maneuver script module
+ * @tableofcontents
+ * In the manual mode every move is a key that has to reach the robot in time, so the same
+ * maneuver never drives twice the same way over the bluetooth connection. A script is sent once
+ * and then runs on the robot alone, so a maneuver can be repeated as often as needed.
+ *
+ * @section secScrUpload Upload
+ * A script is sent with `U` followed by up to #SCRIPT_STEP_AMOUNT steps and ends with the line.
+ * Every step is the key of a direction, `W`, `A`, `B`, `D` or `S` to stand still, the duty of the
+ * wheels, a comma and the duration in milliseconds, the steps are separated by a space:
+ * `UW150,500 A120,200 S0,300`. The turns are on the spot. A script is only kept if every step was
+ * valid, it stays in the sram until the next upload or a reset.
+ *
+ * @section secScrRun Run
+ * `J` starts the script while the robot waits for instructions. The first step is applied right
+ * away, every other step by the millisecond interrupt of timer 1 once the one before took its
+ * time, so the steps keep their durations to the millisecond no matter what the run loop does in
+ * the meantime. After the last step the wheels stop and the robot prints the planned and the
+ * measured time of the whole script.
+ * @sa #script_tick
+ */
+#ifndef DRIVE_SCRIPT_H
+#define DRIVE_SCRIPT_H
+
+#include <stdint.h>
+#include <util/atomic.h>
+#include "robot_types.h"
+#include "motor_output.h"
+
+/** @brief Largest amount of steps in a script */
+#define SCRIPT_STEP_AMOUNT 16
+/** @brief Longest duration of a step in milliseconds */
+#define SCRIPT_DURATION_MAX 30000
+
+/**
+ * @brief One move of a script
+ */
+typedef struct script_step {
+    /**
+     * @brief Direction the robot drives, #DIR_NONE stands still
+     */
+    uint8_t dir;
+    /**
+     * @brief Duty of both wheels
+     */
+    uint8_t duty;
+    /**
+     * @brief Time in milliseconds the move takes
+     */
+    uint16_t duration;
+} script_step;
+
+/**
+ * @brief Drops the stored script, called before the steps of a new one are added
+ */
+void script_clear(void);
+
+/**
+ * @brief Adds a step to the end of the script
+ * @param dir Direction the robot drives, #DIR_NONE stands still
+ * @param duty Duty of both wheels, 0 to #OUTPUT_DUTY_FULL
+ * @param duration Time in milliseconds the move takes, 1 to #SCRIPT_DURATION_MAX
+ * @retval 1 if the step was added
+ * @retval 0 if the script is full or the step is not valid
+ */
+uint8_t script_add(direction dir, int16_t duty, int16_t duration);
+
+/**
+ * @brief Retrieves the amount of steps of the stored script
+ * @return Amount of steps, 0 if no script is stored
+ */
+uint8_t script_get_length(void);
+
+/**
+ * @brief Retrieves the sum of the durations of all steps
+ * @return Planned time of the script in milliseconds
+ */
+uint32_t script_get_planned(void);
+
+/**
+ * @brief Starts the stored script with its first step
+ * @retval 1 if the script runs
+ * @retval 0 if no script is stored
+ */
+uint8_t script_start(void);
+
+/**
+ * @brief Stops a running script, the wheels keep the command of the current step
+ */
+void script_stop(void);
+
+/**
+ * @brief Moves the script on by one millisecond, called by the interrupt of timer 1
+ */
+void script_tick(void);
+
+/**
+ * @brief Checks if the last step of the script is done
+ * @details The result is only returned once, the next call returns 0 again.
+ * @param elapsed Set to the measured time of the script in milliseconds
+ * @retval 1 if the script just ended
+ * @retval 0 otherwise
+ */
+uint8_t script_take_done(uint32_t *elapsed);
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ * @file
+ * @author Larson Schneider
+ * @date 17.10.2026
+ * @brief Decision table of the line following, generated at build time
+ * @version 0.1
+ * @copyright MIT License.
+ *
+ * The tables are defined in drive_table.c, which is written by tools/drive_table_gen.c from the
+ * rules in drive_rules.c and checked by tools/drive_table_check.c before it is compiled.
+ */
+#ifndef DRIVE_TABLE_H
+#define DRIVE_TABLE_H
+
+#include <stdint.h>
+#include "robot_types.h"
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#else
+// The host tools read the tables from the normal memory
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *) (address))
+#endif
+
+/** @brief Amount of entries of the direction table, one for every possible input */
+#define DRIVE_TABLE_SIZE (SENSOR_STATE_AMOUNT * SENSOR_STATE_AMOUNT * DIRECTION_AMOUNT \
+                          * DIRECTION_AMOUNT)
+/** @brief Bits of an entry that contain the direction to drive */
+#define DRIVE_TABLE_RESULT_MASK 0x07
+/** @brief First bit of an entry that contains the new last direction */
+#define DRIVE_TABLE_LAST_SHIFT 3
+/** @brief Bits of an entry that contain the new last direction, after the shift */
+#define DRIVE_TABLE_LAST_MASK 0x07
+/** @brief Bit of an entry that is set if the new last direction is also the last simple one */
+#define DRIVE_TABLE_SIMPLE_BIT 6
+
+/**
+ * @brief Direction to drive for every sensor state, see #rules_evaluate_sensors
+ */
+extern const uint8_t drive_evaluate_table[SENSOR_STATE_AMOUNT] PROGMEM;
+
+/**
+ * @brief Packed result of #rules_calc_direction for every combination of its inputs
+ * @details Indexed by #drive_table_index. Every entry contains the direction to drive, the new
+ * last direction and if the last simple direction takes the new last direction.
+ */
+extern const uint8_t drive_direction_table[DRIVE_TABLE_SIZE] PROGMEM;
+
+/**
+ * @brief Position of the given inputs in #drive_direction_table
+ * @param current Current sensor state
+ * @param last_state Sensor state in last cycle
+ * @param last_dir Last direction driven, that was not #DIR_NONE
+ * @param last_simple Last direction driven, that was #DIR_LEFT or #DIR_RIGHT
+ * @return Index of the entry
+ */
+static inline uint16_t drive_table_index(uint8_t current, uint8_t last_state, uint8_t last_dir,
+                                         uint8_t last_simple) {
+    return (((uint16_t) current * SENSOR_STATE_AMOUNT + last_state) * DIRECTION_AMOUNT + last_dir)
+           * DIRECTION_AMOUNT + last_simple;
+}
+
+/**
+ * @brief Looks up the direction to drive for the given sensor state
+ * @param current Current sensor state
+ * @return Direction to drive
+ */
+static inline direction drive_table_evaluate(sensor_state current) {
+    return (direction) pgm_read_byte(&drive_evaluate_table[current & (SENSOR_STATE_AMOUNT - 1)]);
+}
+
+/**
+ * @brief Looks up the direction to drive and updates the last directions, without any branch
+ * @param current Current sensor state
+ * @param last_state Sensor state in last cycle
+ * @param last_dir Last direction driven, that was not #DIR_NONE
+ * @param last_simple Last direction driven, that was #DIR_LEFT or #DIR_RIGHT
+ * @return Direction to drive
+ */
+static inline direction drive_table_direction(sensor_state current, sensor_state last_state,
+                                              direction *last_dir, direction *last_simple) {
+    uint8_t entry = pgm_read_byte(&drive_direction_table[drive_table_index(
+            current, last_state, *last_dir, *last_simple)]);
+    uint8_t last = (entry >> DRIVE_TABLE_LAST_SHIFT) & DRIVE_TABLE_LAST_MASK;
+    // All ones if the last simple direction takes the new last direction, zero otherwise
+    uint8_t simple_mask = -((entry >> DRIVE_TABLE_SIMPLE_BIT) & 1);
+    *last_dir = (direction) last;
+    *last_simple = (direction) ((*last_simple & ~simple_mask) | (last & simple_mask));
+    return (direction) (entry & DRIVE_TABLE_RESULT_MASK);
+}
+
+#endif
@@ -43,6 +43,7 @@
 #define LED_CONTROL_H
 
 #include <avr/io.h>
+#include "robot_types.h"
 
 // SR clock
 /** @brief Direction Register of the shift clock */
@@ -100,32 +101,6 @@ typedef enum {
     CHASE_FLAG = 8,
 } led_state;
 
-/**
- * @brief Describes the binary state of the sensors
- */
-typedef enum {
-    /**
- * @brief No sensor signal
- */
-    SENSOR_NONE = 0,
-/**
- * @brief Left sensor is high
- */
-    SENSOR_LEFT = 1,
-/**
- * @brief Center sensor is high
- */
-    SENSOR_CENTER = 2,
-/**
- * @brief Right sensor is high
- */
-    SENSOR_RIGHT = 4,
-/**
- * @brief All sensors are high
- */
-    SENSOR_ALL = 7,
-} sensor_state;
-
 /**
  * @brief Initialises all pins and registries that are used by the LED module.
  *
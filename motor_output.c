@@ -0,0 +1,391 @@
+#include "motor_output.h"
+
+/**
+ * @brief Command of the wheels as the drive module built it
+ */
+static motor_frame output_command;
+/**
+ * @brief Command of the wheels with the compensated duties, the ramp moves the pins towards it
+ */
+static motor_frame output_target;
+/**
+ * @brief Duty of the left wheel on the pins, negative if it turns backwards
+ */
+static volatile int16_t output_duty_left = 0;
+/**
+ * @brief Duty of the right wheel on the pins, negative if it turns backwards
+ */
+static volatile int16_t output_duty_right = 0;
+/**
+ * @brief Change of the duty per period of the pwm, zero if the ramp is off
+ */
+static volatile uint8_t output_ramp_step = OUTPUT_RAMP_STEP_DEFAULT;
+/**
+ * @brief Overflows of timer 0 since the last step of the ramp
+ */
+static uint8_t output_ramp_ticks = 0;
+/**
+ * @brief Set once the pins reached the command, the ramp has nothing to do until the next one
+ */
+static volatile uint8_t output_settled = 1;
+/**
+ * @brief Set if the duties are scaled with the voltage of the battery
+ */
+static uint8_t output_compensated = 0;
+/**
+ * @brief Factor of the duties with 8 fraction bits, computed from #output_voltage
+ */
+static uint16_t output_factor = OUTPUT_COMP_ONE;
+/**
+ * @brief Set if the factor of the current command had to be cut to the headroom of its duties
+ */
+static uint8_t output_saturated = 0;
+/**
+ * @brief Filtered voltage of the battery the factor was computed from
+ */
+static uint8_t output_voltage = OUTPUT_COMP_NOMINAL_DEFAULT;
+/**
+ * @brief Voltage of the battery the duties are meant for
+ */
+static uint8_t output_nominal = OUTPUT_COMP_NOMINAL_DEFAULT;
+/**
+ * @brief Set if the factor was cut to #OUTPUT_COMP_FACTOR_MAX
+ */
+static uint8_t output_factor_capped = 0;
+/**
+ * @brief Counters of written and skipped frames
+ */
+static output_stats output_counters = {0, 0};
+
+/**
+ * @brief Checks if two frames contain the same values
+ * @param a First frame
+ * @param b Second frame
+ * @retval 1 if every register has the same value
+ * @retval 0 otherwise
+ */
+static uint8_t output_equals(const motor_frame *a, const motor_frame *b) {
+    return a->port_b == b->port_b && a->port_d == b->port_d && a->wave == b->wave
+           && a->compare_right == b->compare_right && a->compare_left == b->compare_left;
+}
+
+/**
+ * @brief Checks if a wheel of a frame brakes
+ * @param frame Frame to check
+ * @retval 1 if both inputs of a wheel are set
+ * @retval 0 otherwise
+ */
+static uint8_t output_brakes(const motor_frame *frame) {
+    uint8_t left = (1 << OP_M_LF) | (1 << OP_M_LB);
+    uint8_t right = (1 << OP_M_RF) | (1 << OP_M_RB);
+    // The left inputs are on both ports, PD7 and PB0
+    uint8_t inputs_left = (frame->port_d & (1 << OP_M_LF)) | (frame->port_b & (1 << OP_M_LB));
+    return inputs_left == left || (frame->port_b & right) == right;
+}
+
+/**
+ * @brief Writes a frame to the registers without any check
+ * @param frame Frame to write
+ */
+static void output_write(const motor_frame *frame) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        PORTB = (PORTB & ~OUTPUT_PORT_B_MASK) | frame->port_b;
+        PORTD = (PORTD & ~OUTPUT_PORT_D_MASK) | frame->port_d;
+        TIMER_0_WAVE = (TIMER_0_WAVE & ~OUTPUT_WAVE_MASK) | frame->wave;
+        TIMER_0_COMPARE_RESOLUTION_A = frame->compare_right;
+        TIMER_0_COMPARE_RESOLUTION_B = frame->compare_left;
+    }
+}
+
+/**
+ * @brief Writes the command to the registers at once and ends the ramp
+ */
+static void output_settle(void) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        output_write(&output_target);
+        output_duty_left = output_target.duty_left;
+        output_duty_right = output_target.duty_right;
+        output_settled = 1;
+    }
+}
+
+/**
+ * @brief Moves the duty of a wheel one step towards its target
+ * @param current Duty on the pins
+ * @param target Duty of the command
+ * @param step Largest change of the duty
+ * @return Duty after the step
+ */
+static int16_t output_ramp(int16_t current, int16_t target, uint16_t step) {
+    // A wheel that changes its direction has to stop first
+    if ((current > 0 && target < 0) || (current < 0 && target > 0)) {
+        target = 0;
+    }
+    if (target > current + step) {
+        return current + step;
+    }
+    if (target < current - step) {
+        return current - step;
+    }
+    return target;
+}
+
+/**
+ * @brief Direction of a wheel with the given duty
+ * @param duty Duty, negative if the wheel turns backwards
+ * @return Direction of the wheel
+ */
+static orientation output_orientation(int16_t duty) {
+    if (duty > 0) {
+        return OR_FORWARDS;
+    }
+    if (duty < 0) {
+        return OR_BACKWARDS;
+    }
+    return OR_STOP;
+}
+
+/**
+ * @brief Multiplies a duty with a compensation factor
+ * @param duty Duty of the command, negative if the wheel turns backwards
+ * @param factor Factor with 8 fraction bits, small enough that the result fits
+ * @return Compensated absolute duty, at most #OUTPUT_DUTY_FULL
+ */
+static uint8_t output_scale(int16_t duty, uint16_t factor) {
+    uint32_t scaled = ((uint32_t) abs(duty) * factor) >> 8;
+    return scaled > OUTPUT_DUTY_FULL ? OUTPUT_DUTY_FULL : (uint8_t) scaled;
+}
+
+/**
+ * @brief Derives the target of the ramp from the command and starts the ramp towards it
+ */
+static void output_retarget(void) {
+    // A script applies its steps from an interrupt, so the command must not change in between
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        motor_frame frame = output_command;
+        uint16_t factor = output_factor;
+        output_saturated = output_compensated && output_factor_capped
+                           && (frame.duty_left || frame.duty_right);
+        // Both wheels share the factor, so it is cut to the headroom of the larger duty
+        uint8_t largest = abs(frame.duty_left) > abs(frame.duty_right) ? abs(frame.duty_left)
+                                                                       : abs(frame.duty_right);
+        if (output_compensated && largest
+            && factor > ((uint16_t) OUTPUT_DUTY_FULL << 8) / largest) {
+            factor = ((uint16_t) OUTPUT_DUTY_FULL << 8) / largest;
+            output_saturated = 1;
+        }
+        // A wheel without duty keeps its pins, only the duty of a turning wheel is scaled
+        if (output_compensated && frame.duty_left) {
+            output_set_left(&frame, output_orientation(frame.duty_left),
+                            output_scale(frame.duty_left, factor));
+        }
+        if (output_compensated && frame.duty_right) {
+            output_set_right(&frame, output_orientation(frame.duty_right),
+                             output_scale(frame.duty_right, factor));
+        }
+        output_target = frame;
+        output_settled = 0;
+        if (!output_ramp_step || output_brakes(&frame)) {
+            output_settle();
+        }
+    }
+}
+
+ISR (TIMER0_OVF_vect) {
+    if (output_settled) {
+        return;
+    }
+    // Every pwm mode has another period, a step should take about one millisecond in all of them
+    const pwm_setting *pwm = timers_get_pwm_setting();
+    if (++output_ramp_ticks < pwm->ramp_divider) {
+        return;
+    }
+    output_ramp_ticks = 0;
+    uint16_t step = (uint16_t) output_ramp_step * pwm->ramp_scale;
+    int16_t left = output_ramp(output_duty_left, output_target.duty_left, step);
+    int16_t right = output_ramp(output_duty_right, output_target.duty_right, step);
+    if (left == output_target.duty_left && right == output_target.duty_right) {
+        output_settle();
+        return;
+    }
+    output_duty_left = left;
+    output_duty_right = right;
+    motor_frame frame;
+    output_build(&frame, output_orientation(left), (uint8_t) abs(left),
+                 output_orientation(right), (uint8_t) abs(right));
+    output_write(&frame);
+}
+
+void output_init(void) {
+    // Set PD5 and PD6 as output (EN[A|B]!)
+    DR_M_LE |= (1 << DP_M_LE);
+    DR_M_RE |= (1 << DP_M_RE);
+
+    // Set PD7 as output (IN1)
+    DR_M_LF |= (1 << DP_M_LF);
+
+    // Set PB0, PB1, and PB3 as output (IN[2|3|4])
+    DR_M_LB |= (1 << DP_M_LB);
+    DR_M_RB |= (1 << DP_M_RB);
+    DR_M_RF |= (1 << DP_M_RF);
+
+    output_build(&output_command, OR_STOP, 0, OR_STOP, 0);
+    output_target = output_command;
+    output_settle();
+    output_reset_stats();
+    TIMER_0_INTERRUPT |= (1 << TIMER_0_OVERFLOW_INTERRUPT);
+}
+
+void output_set_left(motor_frame *frame, orientation dir, uint8_t duty) {
+    frame->port_b &= ~(1 << OP_M_LB);
+    frame->port_d &= ~((1 << OP_M_LF) | (1 << OP_M_LE));
+    frame->wave &= ~OUTPUT_WAVE_LEFT;
+    frame->compare_left = 0;
+    frame->duty_left = 0;
+    if (dir == OR_FORWARDS) {
+        frame->port_d |= (1 << OP_M_LF);
+        frame->duty_left = duty;
+    } else if (dir == OR_BACKWARDS) {
+        frame->port_b |= (1 << OP_M_LB);
+        frame->duty_left = -duty;
+    } else if (dir == OR_BRAKE) {
+        // The wheel does not turn, so the ramp counts it as standing still
+        frame->port_d |= (1 << OP_M_LF);
+        frame->port_b |= (1 << OP_M_LB);
+    } else {
+        return;
+    }
+    // Only a duty between both ends needs the timer, the ends are set directly on the pin
+    if (duty == OUTPUT_DUTY_FULL) {
+        frame->port_d |= (1 << OP_M_LE);
+    } else if (duty) {
+        frame->wave |= OUTPUT_WAVE_LEFT;
+        frame->compare_left = duty;
+    }
+}
+
+void output_set_right(motor_frame *frame, orientation dir, uint8_t duty) {
+    frame->port_b &= ~((1 << OP_M_RF) | (1 << OP_M_RB));
+    frame->port_d &= ~(1 << OP_M_RE);
+    frame->wave &= ~OUTPUT_WAVE_RIGHT;
+    frame->compare_right = 0;
+    frame->duty_right = 0;
+    if (dir == OR_FORWARDS) {
+        frame->port_b |= (1 << OP_M_RF);
+        frame->duty_right = duty;
+    } else if (dir == OR_BACKWARDS) {
+        frame->port_b |= (1 << OP_M_RB);
+        frame->duty_right = -duty;
+    } else if (dir == OR_BRAKE) {
+        frame->port_b |= (1 << OP_M_RF) | (1 << OP_M_RB);
+    } else {
+        return;
+    }
+    if (duty == OUTPUT_DUTY_FULL) {
+        frame->port_d |= (1 << OP_M_RE);
+    } else if (duty) {
+        frame->wave |= OUTPUT_WAVE_RIGHT;
+        frame->compare_right = duty;
+    }
+}
+
+void output_build(motor_frame *frame, orientation left_dir, uint8_t left_duty,
+                  orientation right_dir, uint8_t right_duty) {
+    frame->port_b = 0;
+    frame->port_d = 0;
+    frame->wave = 0;
+    output_set_left(frame, left_dir, left_duty);
+    output_set_right(frame, right_dir, right_duty);
+}
+
+void output_apply(const motor_frame *frame) {
+    // The script applies its steps from the timer interrupt, so the run loop must not be
+    // interrupted between the compare, the counters and the copy of the command
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        if (output_equals(frame, &output_command)) {
+            output_counters.skipped++;
+        } else {
+            output_counters.written++;
+            output_command = *frame;
+            output_retarget();
+        }
+    }
+}
+
+const motor_frame *output_current(void) {
+    return &output_command;
+}
+
+void output_set_ramp(uint8_t step) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        output_ramp_step = step;
+        if (!step) {
+            output_settle();
+        }
+    }
+}
+
+uint8_t output_get_ramp(void) {
+    return output_ramp_step;
+}
+
+void output_set_compensation(uint8_t enabled) {
+    output_compensated = enabled;
+    output_retarget();
+}
+
+uint8_t output_get_compensation(void) {
+    return output_compensated;
+}
+
+/**
+ * @brief Computes the compensation factor from the nominal and the filtered voltage
+ */
+static void output_update_factor(void) {
+    uint8_t voltage = output_voltage < BATTERY_MIN ? BATTERY_MIN : output_voltage;
+    uint16_t factor = ((uint16_t) output_nominal << 8) / voltage;
+    // A low reading must not multiply the duties without a limit
+    output_factor_capped = factor > OUTPUT_COMP_FACTOR_MAX;
+    output_factor = output_factor_capped ? OUTPUT_COMP_FACTOR_MAX : factor;
+    if (output_compensated) {
+        output_retarget();
+    }
+}
+
+void output_set_voltage(uint8_t voltage) {
+    if (voltage == output_voltage) {
+        return;
+    }
+    output_voltage = voltage;
+    output_update_factor();
+}
+
+void output_set_nominal(uint8_t voltage) {
+    output_nominal = voltage < BATTERY_MIN ? BATTERY_MIN : voltage;
+    output_update_factor();
+}
+
+uint8_t output_get_nominal(void) {
+    return output_nominal;
+}
+
+uint16_t output_get_factor(void) {
+    return output_compensated ? output_factor : OUTPUT_COMP_ONE;
+}
+
+uint8_t output_is_saturated(void) {
+    return output_saturated;
+}
+
+void output_get_stats(output_stats *stats) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        *stats = output_counters;
+    }
+}
+
+void output_reset_stats(void) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        output_counters.written = 0;
+        output_counters.skipped = 0;
+    }
+}
@@ -0,0 +1,376 @@
+/**
+ * @file
+ * @author Larson Schneider
+ * @date 17.10.2026
+ * @brief Writes the commands of the drive module to the pins of the motor driver
+ * @version 0.1
+ * @copyright MIT License.
+ *
+ * This module owns the port bits of the motor driver and the compare outputs of timer 0. A command
+ * for both wheels is translated into a frame of register values once and written in one short
+ * critical section, a frame equal to the one on the pins is not written at all.
+ */
+/**
+ * @page output Motor output module
+ * @tableofcontents
+ * Before, every cycle of the run loop set the direction pins of each wheel one by one and
+ * reconfigured the compare outputs of timer 0, even if the robot kept driving the same move.
+ *
+ * @section secOutFrame Frames
+ * A #motor_frame holds the values of everything the motor driver is connected to: the direction
+ * pins on port B and port D, the enable pins on port D, which are used if a wheel stands still or
+ * runs at full speed, the compare output bits of timer 0 and both compare values. Bits that do not
+ * matter for a frame, like the compare value of a wheel that stands still, are always zero, so two
+ * frames for the same command are equal byte by byte. The drive module builds the frames of its
+ * fixed moves once while initialising.
+ *
+ * @section secOutApply Applying
+ * #output_apply compares the frame with the current command. If nothing changed it only counts
+ * the skipped write, otherwise the frame becomes the new command. A frame is always written as a
+ * whole, the masked bits of both ports, the compare output bits and the compare values with the
+ * interrupts disabled, so the wheels never see half a command.
+ * The counters of written and skipped frames can be printed with `G` to see how often the
+ * commands really change.
+ *
+ * @section secOutRamp Ramps
+ * Jumping from standing still to a high duty, or reversing a wheel at once, lets the wheels slip
+ * and the current spike, which pulls down the voltage of the battery. So #output_apply only sets
+ * the target of the wheels and the overflow interrupt of timer 0 moves the duty of each wheel by
+ * at most #OUTPUT_RAMP_STEP_DEFAULT towards it about once per millisecond, depending on the
+ * @ref secPwmModes "pwm mode". A wheel that has to change its direction is ramped down to zero
+ * first and then up again in the other direction. Once both wheels reached their target the frame
+ * of the command itself is written, so the pins end up exactly as without the ramp. The main loop
+ * never waits for a ramp, and a step of zero writes every command at once like before.
+ * @f[ t_{ramp} \approx \frac{\Delta duty}{step} \cdot 1.024 ms @f]
+ *
+ * @section secOutBrake Braking
+ * With #OR_STOP both inputs of a wheel are low and the enable pin is off, so the wheel coasts and
+ * the robot rolls on for a while. With #OR_BRAKE both inputs are high instead, and while the
+ * enable pin is on the H-bridge shorts the motor, which brakes it with its own voltage. The duty
+ * of a braking wheel is the share of the time the motor is shorted, so the enable pin is driven
+ * exactly like for a turning wheel and the strength of the brake can be set. A brake is never
+ * ramped, a frame with a braking wheel is written at once, and the ramp of the next command
+ * starts from a standing wheel.
+ *
+ * @section secOutBattery Battery Compensation
+ * The duties of the drive module are absolute, but the same duty turns the wheels slower once the
+ * battery drains, so the laps got slower over a session and the robot entered the curves at
+ * another speed. With the compensation switched on, every duty of a command is multiplied by the
+ * nominal voltage divided by the filtered voltage of the battery before it is ramped and written.
+ * The run loop passes the voltage to #output_set_voltage every cycle, the factor is only computed
+ * again if the filtered voltage or the nominal voltage changed. Voltages below #BATTERY_MIN are
+ * treated as #BATTERY_MIN. #output_current always returns the command itself, so the drive module
+ * and the track map still see the nominal duties.
+ *
+ * The nominal voltage is the one the duties of the drive module are meant for. It defaults to
+ * #OUTPUT_COMP_NOMINAL_DEFAULT, the middle between #BATTERY_MIN and #BATTERY_MAX, and is set with
+ * `=N`. A fuller battery scales every duty down, a full one to about 54%, so the robot drives at
+ * the speed of a half drained battery from the start and has the headroom to keep it while the
+ * battery drains further. A low reading can not raise a duty by more than #OUTPUT_COMP_FACTOR_MAX,
+ * so the speed is kept down to half of the nominal voltage, 61 in units of the upper 8 bits of the
+ * adc. A duty d also has to stay below #OUTPUT_DUTY_FULL, so it is only compensated down to the
+ * nominal voltage times d / 255: 105 for #SPEED_OUTER, 96 for #SPEED_INNER, 91 for #SPEED_FAST, and
+ * all slower fixed duties down to 61. Below that the factor is cut to the headroom of the larger
+ * duty of the command, both wheels are scaled by the same factor, so a turn keeps the ratio of its
+ * duties and only the speed drops. Such a command is reported as saturated by #output_is_saturated,
+ * and the state updates send it next to the factor.
+ * @f[ duty_{out} = duty \cdot \min\left(\frac{U_{nominal}}{U_{battery}}, 2,
+ *     \frac{255}{\max(duty_{left}, duty_{right})}\right) @f]
+ */
+#ifndef MOTOR_OUTPUT_H
+#define MOTOR_OUTPUT_H
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <stdlib.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "timers.h"
+#include "robot_sensor.h"
+
+// Direction Register = DR
+// Input Register = IR
+// Output Register = OR
+
+//IN1 Left Forward
+/** @brief Direction Register of the left wheel forward */
+#define DR_M_LF DDRD
+/** @brief Direction Pin of the left wheel forward */
+#define DP_M_LF DD7
+/** @brief Output Register of the left wheel forward */
+#define OR_M_LF PORTD
+/** @brief Output Pin of the left wheel forward */
+#define OP_M_LF PD7
+
+//IN2 Left Backward
+/** @brief Direction Register of the left wheel backward */
+#define DR_M_LB DDRB
+/** @brief Direction Pin of the left wheel backward */
+#define DP_M_LB DD0
+/** @brief Output Register of the left wheel backward */
+#define OR_M_LB PORTB
+/** @brief Output Pin of the left wheel backward */
+#define OP_M_LB PB0
+
+//IN4 Right Forward
+/** @brief Direction Register of the right wheel forward */
+#define DR_M_RF DDRB
+/** @brief Direction Pin of the right wheel forward */
+#define DP_M_RF DD3
+/** @brief Output Register of the right wheel forward */
+#define OR_M_RF PORTB
+/** @brief Output Pin of the right wheel forward */
+#define OP_M_RF PB3
+
+//IN3 Right Backward
+/** @brief Direction Register of the right wheel backward */
+#define DR_M_RB DDRB
+/** @brief Direction Pin of the right wheel backward */
+#define DP_M_RB DD1
+/** @brief Output Register of the right wheel backward */
+#define OR_M_RB PORTB
+/** @brief Output Pin of the right wheel backward */
+#define OP_M_RB PB1
+
+/** @brief First of the two data direction registries used by this module*/
+#define DR_MOTOR_FIRST DDRD
+/** @brief Second of the two data direction registries used by this module*/
+#define DR_MOTOR_SECOND DDRB
+
+// Left Enable
+/** @brief Direction Register of the left motor speed */
+#define DR_M_LE DDRD
+/** @brief Direction Pin of the left motor speed */
+#define DP_M_LE DD5
+/** @brief Output Register of the left motor speed */
+#define OR_M_LE PORTD
+/** @brief Output Pin of the left motor speed  */
+#define OP_M_LE PD5
+
+// Right Enable Motor
+/** @brief Direction Register of the right motor speed */
+#define DR_M_RE DDRD
+/** @brief Direction Pin of the right motor speed */
+#define DP_M_RE DD6
+/** @brief Output Register of the right motor speed */
+#define OR_M_RE PORTD
+/** @brief Output Pin of the right motor speed  */
+#define OP_M_RE PD6
+
+/** @brief Bits of port B that belong to the motor driver */
+#define OUTPUT_PORT_B_MASK ((1 << OP_M_LB) | (1 << OP_M_RF) | (1 << OP_M_RB))
+/** @brief Bits of port D that belong to the motor driver */
+#define OUTPUT_PORT_D_MASK ((1 << OP_M_LF) | (1 << OP_M_LE) | (1 << OP_M_RE))
+/** @brief Compare output bits of timer 0 that connect the right enable pin (OC0A) */
+#define OUTPUT_WAVE_RIGHT (1 << COM0A1)
+/** @brief Compare output bits of timer 0 that connect the left enable pin (OC0B) */
+#define OUTPUT_WAVE_LEFT (1 << COM0B1)
+/** @brief All compare output bits of timer 0 */
+#define OUTPUT_WAVE_MASK ((1 << COM0A1) | (1 << COM0A0) | (1 << COM0B1) | (1 << COM0B0))
+/** @brief Duty of a wheel that runs at full speed, the pin is set without the timer */
+#define OUTPUT_DUTY_FULL 255
+/**
+ * @brief Default change of the duty of a wheel per step of the ramp (about 1 ms)
+ * @details From standing still to #SPEED_OUTER takes 55 steps this way.
+ */
+#define OUTPUT_RAMP_STEP_DEFAULT 4
+/** @brief Compensation factor that leaves the duty unchanged, the factor has 8 fraction bits */
+#define OUTPUT_COMP_ONE 256
+/**
+ * @brief Voltage of the battery the duties of the drive module are meant for after the start
+ * @details The middle of the range of the battery, so a full one scales the duties down and an
+ * almost empty one up. Can be changed at runtime with #output_set_nominal.
+ */
+#define OUTPUT_COMP_NOMINAL_DEFAULT ((BATTERY_MIN + BATTERY_MAX) / 2)
+/** @brief Largest compensation factor, 2 with 8 fraction bits */
+#define OUTPUT_COMP_FACTOR_MAX 512
+
+/**
+ * @brief Possible directions of the two motors.
+ */
+typedef enum {
+/**
+* @brief Move motor forward
+*/
+    OR_FORWARDS,
+/**
+ * @brief Move motor backward
+ */
+    OR_BACKWARDS,
+/**
+ * @brief Stop the motor movement
+ */
+    OR_STOP,
+/**
+ * @brief Short both terminals of the motor, so it brakes instead of coasting
+ */
+    OR_BRAKE
+} orientation;
+
+/**
+ * @brief Values of all registers the motor driver is connected to
+ */
+typedef struct {
+    /**
+     * @brief Bits of #OUTPUT_PORT_B_MASK in port B
+     */
+    uint8_t port_b;
+    /**
+     * @brief Bits of #OUTPUT_PORT_D_MASK in port D
+     */
+    uint8_t port_d;
+    /**
+     * @brief Bits of #OUTPUT_WAVE_MASK in the control register A of timer 0
+     */
+    uint8_t wave;
+    /**
+     * @brief Compare value of the right wheel, zero if the timer is disconnected
+     */
+    uint8_t compare_right;
+    /**
+     * @brief Compare value of the left wheel, zero if the timer is disconnected
+     */
+    uint8_t compare_left;
+    /**
+     * @brief Duty of the left wheel, negative if it turns backwards, zero if it brakes
+     */
+    int16_t duty_left;
+    /**
+     * @brief Duty of the right wheel, negative if it turns backwards, zero if it brakes
+     */
+    int16_t duty_right;
+} motor_frame;
+
+/**
+ * @brief Amount of frames that were written to the registers or skipped since the last reset
+ */
+typedef struct {
+    /**
+     * @brief Frames that changed the command of the wheels
+     */
+    uint32_t written;
+    /**
+     * @brief Frames that were equal to the current command and not written
+     */
+    uint32_t skipped;
+} output_stats;
+
+/**
+ * @brief Sets the pins of the motor driver as outputs and writes a frame that stops both wheels
+ */
+void output_init(void);
+
+/**
+ * @brief Sets the part of a frame that belongs to the left wheel
+ * @param frame Frame to change
+ * @param dir Direction of the wheel, #OR_STOP ignores the duty
+ * @param duty Duty of the wheel, 0 to #OUTPUT_DUTY_FULL, the strength of the brake for #OR_BRAKE
+ */
+void output_set_left(motor_frame *frame, orientation dir, uint8_t duty);
+
+/**
+ * @brief Sets the part of a frame that belongs to the right wheel
+ * @param frame Frame to change
+ * @param dir Direction of the wheel, #OR_STOP ignores the duty
+ * @param duty Duty of the wheel, 0 to #OUTPUT_DUTY_FULL, the strength of the brake for #OR_BRAKE
+ */
+void output_set_right(motor_frame *frame, orientation dir, uint8_t duty);
+
+/**
+ * @brief Builds the frame of a command for both wheels
+ * @param frame Frame to build
+ * @param left_dir Direction of the left wheel
+ * @param left_duty Duty of the left wheel
+ * @param right_dir Direction of the right wheel
+ * @param right_duty Duty of the right wheel
+ */
+void output_build(motor_frame *frame, orientation left_dir, uint8_t left_duty,
+                  orientation right_dir, uint8_t right_duty);
+
+/**
+ * @brief Sets a frame as the command of the wheels, if it differs from the current one
+ * @details The registers are written right away if the ramp is off, otherwise by the ramp. Runs
+ * atomically, as the script applies its steps from the timer interrupt.
+ * @param frame Frame to write
+ */
+void output_apply(const motor_frame *frame);
+
+/**
+ * @brief Retrieves the current command of the wheels
+ * @details The wheels may still be ramping towards it.
+ * @return Frame that was applied last
+ */
+const motor_frame *output_current(void);
+
+/**
+ * @brief Sets how fast the duty of the wheels follows the command
+ * @param step Change of the duty per step of the ramp, zero to write every command at once
+ */
+void output_set_ramp(uint8_t step);
+
+/**
+ * @brief Retrieves how fast the duty of the wheels follows the command
+ * @return Change of the duty per step of the ramp, zero if the ramp is off
+ */
+uint8_t output_get_ramp(void);
+
+/**
+ * @brief Switches the battery compensation of the duties on or off
+ * @details The current command is written again with the new duties.
+ * @param enabled 1 to scale every duty with the voltage of the battery
+ */
+void output_set_compensation(uint8_t enabled);
+
+/**
+ * @brief Checks if the battery compensation of the duties is switched on
+ * @retval 1 if every duty is scaled with the voltage of the battery
+ * @retval 0 otherwise
+ */
+uint8_t output_get_compensation(void);
+
+/**
+ * @brief Updates the compensation factor with the filtered voltage of the battery
+ * @details Does nothing if the voltage did not change since the last call.
+ * @param voltage Filtered voltage of the battery in units of the upper 8 bits of the adc
+ */
+void output_set_voltage(uint8_t voltage);
+
+/**
+ * @brief Sets the voltage of the battery the duties of the drive module are meant for
+ * @details The current command is written again with the new factor.
+ * @param voltage Nominal voltage in units of the upper 8 bits of the adc, at least #BATTERY_MIN
+ */
+void output_set_nominal(uint8_t voltage);
+
+/**
+ * @brief Retrieves the voltage of the battery the duties of the drive module are meant for
+ * @return Nominal voltage in units of the upper 8 bits of the adc
+ */
+uint8_t output_get_nominal(void);
+
+/**
+ * @brief Retrieves the factor every duty is multiplied with
+ * @return Factor with 8 fraction bits, #OUTPUT_COMP_ONE if the compensation is off
+ */
+uint16_t output_get_factor(void);
+
+/**
+ * @brief Checks if the compensation of the current command was cut to the headroom of its duties
+ * @retval 1 if the battery is too low to keep the speed of the current command
+ * @retval 0 otherwise, or if the compensation is off
+ */
+uint8_t output_is_saturated(void);
+
+/**
+ * @brief Copies the counters of written and skipped frames
+ * @details Copied atomically, as the script counts its steps from the timer interrupt.
+ * @param stats Counters since the last reset
+ */
+void output_get_stats(output_stats *stats);
+
+/**
+ * @brief Sets the counters of written and skipped frames to zero
+ */
+void output_reset_stats(void);
+
+#endif
@@ -21,15 +21,31 @@ int main(void) {
     trackState.action = AC_WAIT;
     trackState.pos = POS_UNKNOWN;
     trackState.last_pos = POS_UNKNOWN;
-    trackState.homeCache = 0;
+    trackState.home_since = 0;
+    debounce_init(&trackState.sensor_debounce, SENSOR_DEBOUNCE_COUNT, SENSOR_NONE);
     trackState.manual_dir = DIR_NONE;
-    trackState.manual_dir_last = 0;
+    trackState.manual_level = MANUAL_LEVEL_DEFAULT;
+    trackState.manual_time = 0;
     trackState.manual_driven_before = 0;
     trackState.ui_connection = UI_DISCONNECTED;
     trackState.has_driven_once = 0;
     trackState.dir_last = DIR_NONE;
     trackState.dir_last_valid = DIR_NONE;
     trackState.dir_last_simple = DIR_LEFT;
+    trackState.calib_start = 0;
+    trackState.logic = DRIVE_LOGIC_SENSOR;
+    trackState.learning = 0;
+    trackState.classify = 0;
+    classify_reset(&trackState.classifier, 0);
+    trackState.estimate_lead = 0;
+    estimate_reset(&trackState.estimator);
+    trackState.recovery.stage = RECOVER_NONE;
+    trackState.brake_duty = 0;
+    trackState.brake_time = 0;
+    trackState.brake_since = 0;
+    trackState.speed_last = CLASS_GENTLE;
+    pid_init(&trackState.pid);
+    laps_init();
     // Create counters, has to be done before first use
     timers_create(trackState.counters);
     state_run_loop(&trackState);
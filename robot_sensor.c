@@ -5,7 +5,176 @@
  * @brief Reads the sensors of the robot
  * @version 0.1
  */
+#include <avr/sleep.h>
 #include "robot_sensor.h"
+#include "sensor_calib.h"
+#include "timers.h"
+
+/**
+ * @brief Filters of all channels that are read by the background scan
+ */
+static volatile sensor_filter sensor_filters[ADC_CHANNEL_AMOUNT];
+/**
+ * @brief Channel of the conversion that is currently running
+ */
+static volatile uint8_t sensor_scan_channel = ADMUX_CHN_ADC0;
+/**
+ * @brief If the conversion complete interrupt should start the next conversion
+ */
+static volatile uint8_t sensor_scan_enabled = 0;
+/**
+ * @brief How the samples are currently taken
+ */
+static volatile sensor_mode sensor_mode_current = SENSOR_MODE_SCAN;
+/**
+ * @brief If the field sensors are read in the high rate mode
+ */
+static volatile uint8_t sensor_fast = SENSOR_FAST_DEFAULT;
+/**
+ * @brief Sums of a running noise measurement of the field sensors
+ */
+static volatile sensor_noise sensor_noise_sums[SENSOR_LINE_AMOUNT];
+/**
+ * @brief If the samples should be added to the noise sums
+ */
+static volatile uint8_t sensor_noise_active = 0;
+/**
+ * @brief Rounds over the field sensors since the battery was read last
+ */
+static volatile uint8_t sensor_scan_round = 0;
+/**
+ * @brief Set by the interrupt after the last field sensor of a round was converted
+ */
+static volatile uint8_t sensor_round_done = 0;
+/**
+ * @brief State of the battery, only written by the background scan
+ */
+static volatile battery_state sensor_battery;
+/**
+ * @brief State bit of the sensors on the adc channels 0 to 2
+ */
+static const uint8_t sensor_channel_bits[CALIB_SENSOR_AMOUNT] = {SENSOR_RIGHT, SENSOR_CENTER,
+                                                                 SENSOR_LEFT};
+/**
+ * @brief Result of the last call of #sensor_get_state, needed for the hysteresis
+ */
+static sensor_state sensor_last_state = SENSOR_NONE;
+/**
+ * @brief Last offset of the line that was seen, used for the side if the line is lost
+ */
+static int16_t sensor_last_offset = 0;
+
+/**
+ * @brief Adds a new sample to the filtered voltage of the battery and updates the derived values
+ * @param sample Raw 10 bit sample of the battery channel
+ */
+static void sensor_battery_update(uint16_t sample) {
+    battery_state *battery = (battery_state *) &sensor_battery;
+    battery->filter = battery->filter - (battery->filter >> BATTERY_FILTER_SHIFT) + sample;
+    // 10 bit sample with fraction bits, only the upper 8 bits are the voltage
+    uint8_t voltage = battery->filter >> (BATTERY_FILTER_SHIFT + 2);
+    battery->voltage = voltage;
+    if (voltage <= BATTERY_MIN) {
+        battery->percent = 0;
+    } else if (voltage >= BATTERY_MAX) {
+        battery->percent = 100;
+    } else {
+        battery->percent = (uint16_t) (voltage - BATTERY_MIN) * 100 / (BATTERY_MAX - BATTERY_MIN);
+    }
+    if (voltage < BATTERY_MIN + BATTERY_RANGE) {
+        battery->low = 1;
+    } else if (voltage > BATTERY_MIN + 2 * BATTERY_RANGE) {
+        battery->low = 0;
+    }
+}
+
+/**
+ * @brief Selects the channel and the resolution of the next conversion
+ * @param channel Channel on the adc module as defined
+ * @param fast 1 for the high rate mode, 0 for 10 bits
+ */
+static void sensor_adc_configure(uint8_t channel, uint8_t fast) {
+    uint8_t selection = (A_MUX_SELECTION & ~(ADMUX_CHN_ALL | (1 << A_MUX_LEFT_ADJUST))) | channel;
+    // Writing a one to the interrupt flag would clear it
+    uint8_t status = A_MUX_STATUS
+                     & ~(A_MUX_STATUS_PRE_SCALE_MASK | (1 << A_MUX_STATUS_INTERRUPT_FLAG));
+    if (fast) {
+        selection |= (1 << A_MUX_LEFT_ADJUST);
+        status |= A_MUX_STATUS_PRE_SCALE_FAST;
+    } else {
+        status |= A_MUX_STATUS_PRE_SCALE;
+    }
+    A_MUX_SELECTION = selection;
+    A_MUX_STATUS = status;
+}
+
+/**
+ * @brief Clears the overflow flag of timer 0, unless its interrupt does that itself
+ * @details The ramp of the motor output runs on the overflow interrupt, which clears the flag when
+ * it is executed. Clearing it here before would drop a step of the ramp.
+ */
+static void sensor_clear_overflow(void) {
+    if (!(TIMER_0_INTERRUPT & (1 << TIMER_0_OVERFLOW_INTERRUPT))) {
+        TIMER_0_INTERRUPT_FLAGS = (1 << TIMER_0_OVERFLOW_FLAG);
+    }
+}
+
+/**
+ * @brief Stores the result of the last conversion and starts the conversion of the next channel
+ *
+ * Called after the adc completed a conversion
+ */
+ISR (ADC_vect) {
+    uint8_t channel = sensor_scan_channel;
+    uint16_t sample;
+    if (A_MUX_SELECTION & (1 << A_MUX_LEFT_ADJUST)) {
+        // Only 8 bits are accurate, scale them back to 10 bits
+        sample = A_MUX_RESULT_HIGH << 2;
+    } else {
+        sample = A_MUX_RESULT;
+    }
+
+    // The field sensors are read every round, the battery only every few rounds
+    uint8_t next;
+    if (channel == ADMUX_CHN_ADC3) {
+        next = ADMUX_CHN_ADC0;
+    } else if (channel != ADMUX_CHN_ADC2) {
+        next = channel + 1;
+    } else if (++sensor_scan_round >= BATTERY_SCAN_DIVIDER) {
+        sensor_scan_round = 0;
+        next = ADMUX_CHN_ADC3;
+    } else {
+        next = ADMUX_CHN_ADC0;
+    }
+    sensor_scan_channel = next;
+    sensor_adc_configure(next, sensor_fast && next != ADMUX_CHN_ADC3);
+    // Start right away, the sample is filtered while the next conversion runs
+    if (sensor_scan_enabled) {
+        A_MUX_STATUS |= (1 << A_MUX_STATUS_START);
+    } else if (sensor_mode_current == SENSOR_MODE_PWM_SYNC) {
+        // Only the rising edge of the flag triggers a conversion, so clear it for the next period
+        sensor_clear_overflow();
+    }
+
+    if (scope_progress >= SCOPE_ARMED) {
+        scope_push(channel, sample);
+    }
+    filter_push((sensor_filter *) &sensor_filters[channel], sample);
+    if (channel == ADMUX_CHN_ADC2) {
+        sensor_round_done = 1;
+    }
+    if (channel == ADMUX_CHN_ADC3) {
+        sensor_battery_update(sample);
+    }
+    if (sensor_noise_active && channel < SENSOR_LINE_AMOUNT) {
+        sensor_noise *noise = (sensor_noise *) &sensor_noise_sums[channel];
+        if (noise->count < SENSOR_NOISE_SAMPLES) {
+            noise->count++;
+            noise->sum += sample;
+            noise->squares += (uint32_t) sample * sample;
+        }
+    }
+}
 
 void sensor_clear(void) {
     // The following lines still let the digital input registers enabled,
@@ -14,6 +183,15 @@ void sensor_clear(void) {
 }
 
 void sensor_init(void) {
+    calib_load();
+    for (uint8_t channel = 0; channel < ADC_CHANNEL_AMOUNT; ++channel) {
+        filter_init((sensor_filter *) &sensor_filters[channel],
+                    channel == ADMUX_CHN_ADC3 ? SENSOR_FILTER_BATTERY : SENSOR_FILTER_LINE);
+        if (channel < SENSOR_LINE_AMOUNT) {
+            filter_set_adaptive((sensor_filter *) &sensor_filters[channel], SENSOR_WINDOW_SHIFT_MIN,
+                                SENSOR_WINDOW_SHIFT_MAX, SENSOR_NOISE_TARGET);
+        }
+    }
     DR_ADC_0 &= ~(1 << DP_ADC_0);
     DR_ADC_1 &= ~(1 << DP_ADC_1);
     DR_ADC_2 &= ~(1 << DP_ADC_2);
@@ -44,6 +222,156 @@ void sensor_init(void) {
         // zzzZZZzzzZZZzzz ... take a sleep until measurement done.
     }
     A_MUX_RESULT;
+
+    // Start with the average of some samples, so the battery is not low until the filter settled
+    uint16_t seed = sensor_adc_read_avg(ADMUX_CHN_ADC3, BATTERY_SEED_SAMPLES);
+    sensor_battery.filter = seed << BATTERY_FILTER_SHIFT;
+    sensor_battery_update(seed);
+
+    sensor_scan_start();
+}
+
+void sensor_scan_start(void) {
+    uint8_t channel = sensor_scan_channel;
+    sensor_adc_configure(channel, sensor_fast && channel != ADMUX_CHN_ADC3);
+    A_MUX_STATUS |= (1 << A_MUX_STATUS_INTERRUPT);
+    if (sensor_mode_current == SENSOR_MODE_SCAN) {
+        sensor_scan_enabled = 1;
+        A_MUX_STATUS |= (1 << A_MUX_STATUS_START);
+    } else if (sensor_mode_current == SENSOR_MODE_PWM_SYNC) {
+        A_MUX_TRIGGER = (A_MUX_TRIGGER & ~A_MUX_TRIGGER_MASK) | A_MUX_TRIGGER_TIMER_0_OVERFLOW;
+        // A pending overflow would trigger right away, at an arbitrary phase
+        sensor_clear_overflow();
+        A_MUX_STATUS |= (1 << A_MUX_STATUS_AUTO_TRIGGER);
+    }
+}
+
+void sensor_scan_stop(void) {
+    sensor_scan_enabled = 0;
+    A_MUX_STATUS &= ~(1 << A_MUX_STATUS_AUTO_TRIGGER);
+    while (A_MUX_STATUS & (1 << A_MUX_STATUS_START)) {
+        // Let the running conversion finish
+    }
+    // Writing the flag clears a pending interrupt of the last conversion
+    A_MUX_STATUS &= ~(1 << A_MUX_STATUS_INTERRUPT);
+    A_MUX_STATUS |= (1 << A_MUX_STATUS_INTERRUPT_FLAG);
+}
+
+void sensor_set_mode(sensor_mode mode) {
+    sensor_scan_stop();
+    sensor_mode_current = mode;
+    // A synchronized sample takes a whole pwm period, so fewer of them are averaged
+    uint8_t sync = mode == SENSOR_MODE_PWM_SYNC;
+    for (uint8_t channel = 0; channel < SENSOR_LINE_AMOUNT; ++channel) {
+        filter_set_adaptive((sensor_filter *) &sensor_filters[channel],
+                            sync ? SENSOR_SYNC_SHIFT_MIN : SENSOR_WINDOW_SHIFT_MIN,
+                            sync ? SENSOR_SYNC_SHIFT_MAX : SENSOR_WINDOW_SHIFT_MAX,
+                            SENSOR_NOISE_TARGET);
+    }
+    sensor_scan_start();
+}
+
+sensor_mode sensor_get_mode(void) {
+    return sensor_mode_current;
+}
+
+void sensor_set_fast(uint8_t fast) {
+    sensor_scan_stop();
+    sensor_fast = fast;
+    sensor_scan_start();
+}
+
+uint8_t sensor_is_fast(void) {
+    return sensor_fast;
+}
+
+void sensor_sample_sleep(uint8_t conversions) {
+    if (sensor_mode_current != SENSOR_MODE_SLEEP) {
+        return;
+    }
+    set_sleep_mode(SLEEP_MODE_ADC);
+    for (uint8_t i = 0; i < conversions; ++i) {
+        // The interrupt already configures the next conversion, so check the resolution before
+        uint8_t ticks = (A_MUX_SELECTION & (1 << A_MUX_LEFT_ADJUST)) ? SENSOR_SLEEP_TICKS_FAST
+                                                                     : SENSOR_SLEEP_TICKS;
+        // The timers stop while sleeping, so only stretch the low phase of the motors
+        timers_wait_pwm_off();
+        // Entering the sleep mode starts the conversion, its interrupt wakes the cpu again
+        do {
+            sleep_enable();
+            sleep_cpu();
+            sleep_disable();
+        } while (A_MUX_STATUS & (1 << A_MUX_STATUS_START));
+        timers_add_ticks(ticks);
+    }
+}
+
+void sensor_measure_noise(sensor_mode mode, uint16_t *variance) {
+    sensor_mode old_mode = sensor_mode_current;
+    sensor_set_mode(mode);
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        for (uint8_t channel = 0; channel < SENSOR_LINE_AMOUNT; ++channel) {
+            sensor_noise_sums[channel].count = 0;
+            sensor_noise_sums[channel].sum = 0;
+            sensor_noise_sums[channel].squares = 0;
+        }
+        sensor_noise_active = 1;
+    }
+    uint8_t done = 0;
+    while (!done) {
+        sensor_sample_sleep(1);
+        done = 1;
+        for (uint8_t channel = 0; channel < SENSOR_LINE_AMOUNT; ++channel) {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                done &= sensor_noise_sums[channel].count >= SENSOR_NOISE_SAMPLES;
+            }
+        }
+    }
+    sensor_noise_active = 0;
+    sensor_set_mode(old_mode);
+
+    for (uint8_t channel = 0; channel < SENSOR_LINE_AMOUNT; ++channel) {
+        const sensor_noise *noise = (const sensor_noise *) &sensor_noise_sums[channel];
+        // 16 * (squares - sum² / n) / n, with n as a power of two
+        uint32_t squares = noise->squares << 4;
+        uint32_t mean_squares = ((uint32_t) noise->sum * noise->sum) >> (SENSOR_NOISE_SHIFT - 4);
+        variance[channel] = (squares - mean_squares) >> SENSOR_NOISE_SHIFT;
+    }
+}
+
+uint16_t sensor_scan_value(uint8_t channel) {
+    uint16_t value;
+    // The output is two bytes wide, the interrupt could change it in between
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        value = sensor_filters[channel].output;
+    }
+    return value;
+}
+
+uint8_t sensor_take_round(void) {
+    uint8_t done;
+    // The interrupt could finish the next round between reading and clearing the flag
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        done = sensor_round_done;
+        sensor_round_done = 0;
+    }
+    return done;
+}
+
+uint8_t sensor_get_window(uint8_t channel) {
+    return 1 << sensor_filters[channel].shift;
+}
+
+uint16_t sensor_get_noise(uint8_t channel) {
+    uint16_t noise;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        noise = filter_get_noise((const sensor_filter *) &sensor_filters[channel]);
+    }
+    return noise;
+}
+
+void sensor_filter_select(uint8_t channel, filter_type type) {
+    sensor_filters[channel].type = type;
 }
 
 /** We have a 10-bit-ADC, so somewhere in memory we have to read that
@@ -51,11 +379,13 @@ void sensor_init(void) {
  */
 uint16_t sensor_adc_read(uint8_t channel) {
     // Remember to have the ADC initialized!
+    uint8_t sampling = A_MUX_STATUS & (1 << A_MUX_STATUS_INTERRUPT);
+    if (sampling) {
+        sensor_scan_stop();
+    }
 
-    // The following line does set all ADMUX-MUX-pins to 0, disconnects
-    // all channels from the MUX.
-    A_MUX_SELECTION &= ~ADMUX_CHN_ALL;
-    A_MUX_SELECTION |= channel;
+    // Selects the channel, always with the full 10 bits
+    sensor_adc_configure(channel, 0);
 
     // We start a single measurement and then busy-wait until
     // the ADSC-bit goes to 0, signalling the end of the measurement.
@@ -65,34 +395,91 @@ uint16_t sensor_adc_read(uint8_t channel) {
     }
     // Again, a pointer-airthmetical expression. the ADC-register has a
     // lower and a higher portion, but
-    return A_MUX_RESULT;
+    uint16_t value = A_MUX_RESULT;
+    if (sampling) {
+        sensor_scan_start();
+    }
+    return value;
 }
 
 uint16_t sensor_adc_read_avg(uint8_t channel, uint8_t amount_samples) {
-    // How large does our datatype need to be?
-    float sum = 0;
+    // 255 samples of 10 bits need 18 bits, no floating point needed for that
+    uint32_t sum = 0;
 
     for (uint8_t i = 0; i < amount_samples; ++i) {
         sum += sensor_adc_read(channel);
     }
 
-    return (uint16_t)(sum / (float) amount_samples);
+    return (uint16_t)(sum / amount_samples);
 }
 
 sensor_state sensor_get_state() {
     sensor_state value = 0;
-    if (sensor_adc_read_avg(ADMUX_CHN_ADC2, ADC_AVG_AMOUNT) > SIGNAL_LEFT_UPPER) {
-        value |= SENSOR_LEFT;
+    // One round over the field sensors, only done in the sleep mode, the windows fill over calls
+    sensor_sample_sleep(SENSOR_LINE_AMOUNT);
+    for (uint8_t channel = 0; channel < CALIB_SENSOR_AMOUNT; ++channel) {
+        uint8_t bit = sensor_channel_bits[channel];
+        // A sensor that saw the line keeps it until it falls below the lower threshold
+        uint16_t threshold = (sensor_last_state & bit) ? calib_current.lower[channel]
+                                                        : calib_current.upper[channel];
+        if (sensor_scan_value(channel) > threshold) {
+            value |= bit;
+        }
     }
-    if (sensor_adc_read_avg(ADMUX_CHN_ADC1, ADC_AVG_AMOUNT) > SIGNAL_CENTER_UPPER) {
-        value |= SENSOR_CENTER;
+    sensor_last_state = value;
+    return value;
+}
+
+/**
+ * @brief Scales the value of a sensor between its background and line level
+ * @param channel Adc channel of the sensor
+ * @return 0 on the background to 255 on the line
+ */
+static uint8_t sensor_scale(uint8_t channel) {
+    uint16_t value = sensor_scan_value(channel);
+    uint16_t background = calib_current.background[channel];
+    uint16_t contrast = calib_current.line[channel] - background;
+    if (value <= background) {
+        return 0;
     }
-    if (sensor_adc_read_avg(ADMUX_CHN_ADC0, ADC_AVG_AMOUNT) > SIGNAL_RIGHT_UPPER) {
-        value |= SENSOR_RIGHT;
+    if (value - background >= contrast) {
+        return 255;
     }
-    return value;
+    // 256 * d / contrast, both sides scaled so 16 bit are enough
+    uint16_t scaled = ((value - background) << 6) / (contrast >> 2);
+    return scaled > 255 ? 255 : scaled;
+}
+
+void sensor_get_position(line_position *position) {
+    uint8_t right = sensor_scale(ADMUX_CHN_ADC0);
+    uint8_t center = sensor_scale(ADMUX_CHN_ADC1);
+    uint8_t left = sensor_scale(ADMUX_CHN_ADC2);
+    uint8_t strongest = right > center ? right : center;
+    strongest = left > strongest ? left : strongest;
+    position->confidence = strongest;
+    if (strongest < LINE_CONFIDENCE_MIN) {
+        if (sensor_last_offset < 0) {
+            position->offset = -LINE_OFFSET_LOST;
+        } else if (sensor_last_offset > 0) {
+            position->offset = LINE_OFFSET_LOST;
+        } else {
+            position->offset = 0;
+        }
+        return;
+    }
+    uint16_t sum = right + center + left;
+    position->offset = (int16_t) (((int32_t) right - left) * LINE_OFFSET_SENSOR / sum);
+    sensor_last_offset = position->offset;
 }
 
 uint8_t sensor_get_battery(void) {
-    return (uint8_t)(sensor_adc_read_avg(ADMUX_CHN_ADC3, 100));
+    return sensor_battery.percent;
+}
+
+uint8_t sensor_get_battery_voltage(void) {
+    return sensor_battery.voltage;
+}
+
+uint8_t sensor_battery_low(void) {
+    return sensor_battery.low;
 }
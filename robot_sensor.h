@@ -26,26 +26,119 @@
  * @sa #ADMUX_CHN_ADC3
  * @sa #ADMUX_CHN_ALL
  *
+ * @section secScan Background Scan
+ * The adc is not polled by the main loop. Instead the conversion complete interrupt of the adc
+ * passes every result to the @ref filter "filter" of the current channel, switches the multiplexer
+ * to the next channel and starts the next conversion. Like this the channels ADC0 to ADC3 are read
+ * one after the other without any help of the main loop. Reading a value of a channel only copies
+ * the last output of its filter which never waits on the adc, so the speed of the
+ * @ref secCycle "work cycle" no longer depends on how long the sampling takes.
+ * While the @ref scope "scope" is armed, every raw sample is also written into its buffer.
+ * @sa #sensor_scan_start
+ * @sa #sensor_scan_value
+ * @sa #sensor_filter_select
+ *
  * @section Reflective Optical Sensors
  * We use three reflective optical sensors for detection of the @ref track "track". Every sensor
- * has its own threshold when the program will accept a line to be found this is needed because
- * every sensor has a different calibration. Every measurement is done multiple times to reduce the
+ * has its own thresholds when the program will accept a line to be found this is needed because
+ * every sensor has a different calibration. The thresholds are measured by the
+ * @ref calib "calibration module". Every measurement is done multiple times to reduce the
  * possibility that indirect noise can distort the result. (The amount is defined in
- * @ref ADC_AVG_AMOUNT)
- * @sa #ADC_AVG_AMOUNT
+ * @ref FILTER_WINDOW_SIZE)
+ * @sa #SENSOR_FILTER_LINE
+ * @sa #calib_load
  * @sa #SIGNAL_RIGHT_UPPER
  * @sa #SIGNAL_CENTER_UPPER
  * @sa #SIGNAL_LEFT_UPPER
  *
+ * @section secLinePos Line Position
+ * Besides the state of the sensors, which only knows if a sensor sees the line or not, the analog
+ * values of the three sensors give a continuous position of the line. Every value is scaled
+ * between the background and line level of its sensor and the position is the weighted centroid
+ * of the scaled values, with the left sensor at -1, the center sensor at 0 and the right sensor at
+ * +1 (times #LINE_OFFSET_SENSOR).
+ * @f[ offset = \frac{n_{right} - n_{left}}{n_{left} + n_{center} + n_{right}} @f]
+ * @sa #sensor_get_position
+ *
+ * @section secSleep Noise Reduction
+ * The adc is disturbed by the switching of the cpu, the motor pwm and the usart. In the
+ * #SENSOR_MODE_SLEEP every conversion is done in the adc noise reduction sleep mode, which stops
+ * the clock of the cpu and of all io modules until the conversion is done. As this also stops the
+ * timers, a conversion is only started in the low phase of the motor pwm, which is then only
+ * stretched by the time of the conversion, and the missed time is added to timer 1 afterwards so
+ * #millis stays correct. The usart is stopped as well, so bytes that are received during a
+ * conversion can get lost. @n
+ * Every time the state is read in this mode, each field sensor is converted once, so a decision
+ * costs at most #SENSOR_LINE_AMOUNT conversions and as many waits for the low phase of the pwm,
+ * which is bounded by #TIMERS_PWM_WAIT_LIMIT. The windows of the filters fill up over the
+ * following reads, so the filtered value lags by as many loop cycles as the window is long
+ * (see @ref secAdapt). @n
+ * The noise of all modes can be compared with #sensor_measure_noise.
+ *
+ * @section secSync PWM Synchronized Sampling
+ * In the #SENSOR_MODE_PWM_SYNC the conversions are not started by the interrupt but automatically
+ * by the overflow of timer 0, the only event of that timer the adc can be triggered by that does
+ * not move with the duty. The adc holds the sample two adc clock cycles (16 microseconds) after
+ * the trigger, so every sample is taken at the same phase of the pwm period. Where that phase is
+ * depends on the @ref secPwmModes "pwm mode":
+ * - #PWM_MODE_PHASE_CORRECT: the overflow is at the bottom of the counter, which is the middle of
+ *   the on phase of both motors. The sample is 4 timer ticks after it, so it is as far from the
+ *   edges as a fixed trigger can be as long as the compare values are above 4.
+ * - #PWM_MODE_FAST: the overflow switches both motors on, the sample is 4 of 256 timer ticks
+ *   after that edge, so it can still see its transient.
+ * - #PWM_MODE_HIGH_FREQUENCY: the overflow switches both motors on as well, but the sample is 32
+ *   of 256 timer ticks after the edge.
+ *
+ * The phase correct mode is the one this mode is meant for. `H` measures the variance of the
+ * samples with and without the synchronization in every pwm mode while the motors are stalled,
+ * so the phase of each mode can be checked on the robot. Only the rising edge of the overflow flag
+ * triggers a conversion. The overflow interrupt of the @ref secOutRamp "ramp" clears the flag in
+ * every period, so the trigger is armed again without touching it, which would drop a step of the
+ * ramp. Only if that interrupt is off the flag is cleared by the conversion complete interrupt. One
+ * channel is sampled per pwm period, so a field sensor is read at a third of the pwm frequency,
+ * about 163 Hz in the phase correct mode. That is slow against the other modes, so the filters
+ * only average between 2^#SENSOR_SYNC_SHIFT_MIN and 2^#SENSOR_SYNC_SHIFT_MAX samples here, which
+ * keeps their delay below 25 ms.
+ *
+ * @section secAdapt Adaptive Oversampling
+ * A clean sample needs no averaging, a noisy one a lot of it. The filter of every field sensor
+ * keeps a running estimate of the noise of its samples and sizes its averaging window to the
+ * smallest power of two between 2^#SENSOR_WINDOW_SHIFT_MIN and 2^#SENSOR_WINDOW_SHIFT_MAX samples
+ * whose average keeps less than #SENSOR_NOISE_TARGET LSB of noise (see @ref secFilAdapt). In the
+ * background and the pwm synchronized mode a smaller window means the filtered value follows the
+ * line with less delay, in the sleep mode it lags by fewer cycles of the loop.
+ * @sa #sensor_get_window
+ * @sa #sensor_get_noise
+ *
+ * @section secFast High Rate Mode
+ * A conversion takes 13 clock cycles of the adc, with the default pre scale of 128 that is about
+ * 104 microseconds. Deciding if a sensor sees the line does not need all 10 bits, so in the high
+ * rate mode the field sensors are converted with a pre scale of 32 and only the upper 8 bits of the
+ * left adjusted result are read, which are the bits that are still accurate at this clock. A
+ * conversion then only takes about 26 microseconds. The 8 bits are shifted back to 10 bits before
+ * they are filtered, so the calibration and all thresholds stay the same in both modes. The
+ * battery and the calibration are always read with 10 bits.
+ * @sa #sensor_set_fast
+ *
  * @section secBat Battery Voltage
  * The last channel we use is for the battery voltage. The battery is connected to the pin adc 3 via
- * a voltage divider.
+ * a voltage divider. @n
+ * The voltage of the battery changes slowly, so the background scan only reads it once every
+ * #BATTERY_SCAN_DIVIDER rounds over the field sensors. Every sample goes into a slow exponential
+ * filter and the percentage and low flag are computed right away, so reading the state of the
+ * battery costs nothing. The voltage is measured in units of the upper 8 bits of the adc.
+ * @sa #sensor_get_battery
+ * @sa #sensor_battery_low
  */
 #ifndef RO_SIGNALS
 #define RO_SIGNALS
 
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
 #include "utility.h"
+#include "sensor_filter.h"
+#include "sensor_scope.h"
 
 /** @brief Data direction registry of the right sensor */
 #define DR_ADC_0 DDRC
@@ -79,9 +172,33 @@
  * @details sysclock-division of 128
  * @details With this the ADC can run with up to 125 kHz
  */
-#define A_MUX_STATUS_PRE_SCALE (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0)
+#define A_MUX_STATUS_PRE_SCALE ((1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0))
+/** @brief Bits determine the division factor between the system clock
+ * frequency and the input clock to the ADC in the high rate mode
+ * @details sysclock-division of 32
+ * @details With this the ADC runs with 500 kHz, which only leaves 8 bits accurate
+ */
+#define A_MUX_STATUS_PRE_SCALE_FAST ((1 << ADPS2) | (1 << ADPS0))
+/** @brief All bits of the pre scale of the adc */
+#define A_MUX_STATUS_PRE_SCALE_MASK ((1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0))
+/** @brief Flag to left adjust the result, the upper 8 bits are then in #A_MUX_RESULT_HIGH */
+#define A_MUX_LEFT_ADJUST ADLAR
+/** @brief Flag to enable the conversion complete interrupt */
+#define A_MUX_STATUS_INTERRUPT ADIE
+/** @brief Flag that is set if a conversion is complete and the interrupt is pending */
+#define A_MUX_STATUS_INTERRUPT_FLAG ADIF
+/** @brief Flag to start the conversions by the trigger source in #A_MUX_TRIGGER */
+#define A_MUX_STATUS_AUTO_TRIGGER ADATE
+/** @brief Register to select the trigger source of the adc */
+#define A_MUX_TRIGGER ADCSRB
+/** @brief All bits of the trigger source */
+#define A_MUX_TRIGGER_MASK ((1 << ADTS2) | (1 << ADTS1) | (1 << ADTS0))
+/** @brief Trigger source for the overflow of timer 0 */
+#define A_MUX_TRIGGER_TIMER_0_OVERFLOW (1 << ADTS2)
 /** @brief Registry that contains the result when the conversion is complete */
 #define A_MUX_RESULT ADCW
+/** @brief Registry that contains the upper 8 bits of a left adjusted result */
+#define A_MUX_RESULT_HIGH ADCH
 
 /**
  * @brief First channel, used for right sensor
@@ -122,26 +239,70 @@
  * @sa #ADMUX_CHN_ADC2
  */
 #define ADMUX_CHN_ALL 3  // 0000 0011
+/** @brief Amount of channels that are read by the background scan */
+#define ADC_CHANNEL_AMOUNT 4
+/** @brief Amount of channels of the field sensors, these are ADC0 to ADC2 */
+#define SENSOR_LINE_AMOUNT 3
+/** @brief Adc clock cycles of one conversion, see datasheet p.252 */
+#define ADC_CONVERSION_CYCLES 13
+/** @brief Division factor between system clock and adc clock, see #A_MUX_STATUS_PRE_SCALE */
+#define ADC_PRE_SCALE_FACTOR 128
+/** @brief Division factor in the high rate mode, see #A_MUX_STATUS_PRE_SCALE_FAST */
+#define ADC_PRE_SCALE_FACTOR_FAST 32
+/**
+ * @brief If the field sensors are read in the high rate mode after the start
+ * @details Can be changed at runtime with #sensor_set_fast
+ */
+#define SENSOR_FAST_DEFAULT 0
 
+/** @brief Smallest window of the filters of the field sensors, as shift */
+#define SENSOR_WINDOW_SHIFT_MIN 1
+/** @brief Largest window of the filters of the field sensors, as shift */
+#define SENSOR_WINDOW_SHIFT_MAX FILTER_WINDOW_SHIFT
+/** @brief Smallest window of the filters of the field sensors in the pwm synchronized mode */
+#define SENSOR_SYNC_SHIFT_MIN 0
+/** @brief Largest window of the filters of the field sensors in the pwm synchronized mode */
+#define SENSOR_SYNC_SHIFT_MAX 2
 /**
- * @brief Amount of measurements made by the analog-digital-converter
- * @details Average some measurements to reduce probable noise.
+ * @brief Standard deviation in LSB that the average of a field sensor may keep
+ * @details Small against the gap between the lower and the upper threshold, so the noise alone
+ * does not flip the state of a sensor.
  */
-#define ADC_AVG_AMOUNT 20
+#define SENSOR_NOISE_TARGET 2
+/**
+ * @brief Ticks of timer 1 that are missed during one conversion in the sleep mode
+ * @details Timer 1 runs with a pre scale of 64
+ */
+#define SENSOR_SLEEP_TICKS (ADC_CONVERSION_CYCLES * ADC_PRE_SCALE_FACTOR / 64)
+/** @brief Ticks of timer 1 that are missed during one conversion in the high rate mode */
+#define SENSOR_SLEEP_TICKS_FAST (ADC_CONVERSION_CYCLES * ADC_PRE_SCALE_FACTOR_FAST / 64)
+
+/** @brief Shift that equals the amount of samples per channel of a noise measurement, at least 4 */
+#define SENSOR_NOISE_SHIFT 6
+/** @brief Samples per channel of a noise measurement */
+#define SENSOR_NOISE_SAMPLES (1 << SENSOR_NOISE_SHIFT)
+
+/** @brief Filter that is used for the channels of the reflective optical sensors */
+#define SENSOR_FILTER_LINE FILTER_BOXCAR
+/** @brief Filter that is used for the channel of the battery */
+#define SENSOR_FILTER_BATTERY FILTER_IIR
 
 /**
- * @brief Threshold of the right sensor
- * @details This will determine if the signal of the sensor is read as positive.
+ * @brief Default threshold of the right sensor
+ * @details This will determine if the signal of the sensor is read as positive, as long as no
+ * calibration is stored.
  */
 #define SIGNAL_RIGHT_UPPER 220
 /**
- * @brief Threshold of the center sensor
- * @details This will determine if the signal of the sensor is read as positive.
+ * @brief Default threshold of the center sensor
+ * @details This will determine if the signal of the sensor is read as positive, as long as no
+ * calibration is stored.
  */
 #define SIGNAL_CENTER_UPPER 160
 /**
- * @brief Threshold of the left sensor
- * @details This will determine if the signal of the sensor is read as positive.
+ * @brief Default threshold of the left sensor
+ * @details This will determine if the signal of the sensor is read as positive, as long as no
+ * calibration is stored.
  */
 #define SIGNAL_LEFT_UPPER 250
 
@@ -149,14 +310,211 @@
 #define BATTERY_MIN 20
 /** @brief Max Operating Voltage of the board */
 #define BATTERY_MAX 225
-/** @brief Range in that the battery voltage can fluctuate */
+/**
+ * @brief Range in that the battery voltage can fluctuate
+ * @details The battery is low below #BATTERY_MIN plus this range and only stops being low above
+ * #BATTERY_MIN plus twice this range.
+ */
 #define BATTERY_RANGE 10
+/** @brief The battery is read once every n rounds of the background scan over the field sensors */
+#define BATTERY_SCAN_DIVIDER 32
+/** @brief Smoothing of the battery voltage, every sample moves it by 1/2^n of the difference */
+#define BATTERY_FILTER_SHIFT 6
+/** @brief Amount of samples that are averaged for the first value of the battery */
+#define BATTERY_SEED_SAMPLES 16
+
+/**
+ * @brief State of the battery, updated by the background scan
+ */
+typedef struct battery_state {
+    /**
+     * @brief Filtered voltage of the battery, contains #BATTERY_FILTER_SHIFT fraction bits
+     */
+    uint16_t filter;
+    /**
+     * @brief Filtered voltage of the battery in units of the upper 8 bits of the adc
+     */
+    uint8_t voltage;
+    /**
+     * @brief Voltage between #BATTERY_MIN and #BATTERY_MAX in percent
+     */
+    uint8_t percent;
+    /**
+     * @brief 1 if the battery is low
+     */
+    uint8_t low;
+} battery_state;
+
+/**
+ * @brief Offset of the line if it is exactly below the left or right sensor
+ * @details The offset is a fixed point value with this as one distance between two sensors.
+ */
+#define LINE_OFFSET_SENSOR 256
+/**
+ * @brief Offset that is reported if the line was lost, it is outside of the outer sensors
+ */
+#define LINE_OFFSET_LOST 384
+/**
+ * @brief Min confidence of the line position, if the strongest sensor sees less the line is lost
+ */
+#define LINE_CONFIDENCE_MIN 64
+
+/**
+ * @brief Ways how the samples of the adc are taken
+ */
+typedef enum {
+    /**
+     * @brief The adc runs all the time in the background, started by its own interrupt
+     */
+    SENSOR_MODE_SCAN,
+    /**
+     * @brief Every conversion is done in the noise reduction sleep mode of the cpu, started
+     * while reading the state of the sensors
+     */
+    SENSOR_MODE_SLEEP,
+    /**
+     * @brief Every conversion is triggered by the overflow of timer 0, at a fixed phase of the
+     * motor pwm
+     */
+    SENSOR_MODE_PWM_SYNC
+} sensor_mode;
+
+/**
+ * @brief Sums of the samples of one channel during a noise measurement
+ */
+typedef struct sensor_noise {
+    /**
+     * @brief Amount of samples that were added
+     */
+    uint16_t count;
+    /**
+     * @brief Sum of all samples
+     */
+    uint16_t sum;
+    /**
+     * @brief Sum of the squares of all samples
+     */
+    uint32_t squares;
+} sensor_noise;
+
+/**
+ * @brief Lateral position of the line below the robot
+ */
+typedef struct line_position {
+    /**
+     * @brief Offset of the line from the center sensor, negative if the line is on the left and
+     * positive if it is on the right. #LINE_OFFSET_SENSOR is the distance between two sensors.
+     */
+    int16_t offset;
+    /**
+     * @brief How clearly the line is seen, 0 (not at all) to 255 (a sensor is fully on the line)
+     */
+    uint8_t confidence;
+} line_position;
+
+/**
+ * @brief Starts the sampling of the channels ADC0 to ADC3 in the current mode
+ * @details Enables the conversion complete interrupt. In the #SENSOR_MODE_SCAN the first
+ * conversion is started and every following conversion is started by the interrupt itself. In the
+ * #SENSOR_MODE_PWM_SYNC the conversions are started by the overflow of timer 0.
+ * @sa #sensor_scan_stop
+ * @sa #sensor_set_mode
+ */
+void sensor_scan_start(void);
+
+/**
+ * @brief Stops the sampling and waits until the running conversion is done
+ * @sa #sensor_scan_start
+ */
+void sensor_scan_stop(void);
+
+/**
+ * @brief Changes how the samples of the adc are taken
+ * @param mode New mode
+ */
+void sensor_set_mode(sensor_mode mode);
+
+/**
+ * @brief Retrieves how the samples of the adc are taken
+ * @return Current mode
+ */
+sensor_mode sensor_get_mode(void);
+
+/**
+ * @brief Enables or disables the high rate mode for the field sensors
+ * @details The battery is always read with 10 bits.
+ * @param fast 1 to read the field sensors with 8 bits and a faster adc clock, 0 for 10 bits
+ */
+void sensor_set_fast(uint8_t fast);
+
+/**
+ * @brief Checks if the field sensors are read in the high rate mode
+ * @retval 1 if the high rate mode is enabled
+ * @retval 0 otherwise
+ */
+uint8_t sensor_is_fast(void);
+
+/**
+ * @brief Does the given amount of conversions in the noise reduction sleep mode of the cpu
+ * @details Every conversion starts in the low phase of the motor pwm and the time that timer 1
+ * missed during the sleep is added to it afterwards. Only has an effect in #SENSOR_MODE_SLEEP.
+ * @param conversions Amount of conversions, every one samples the next channel
+ */
+void sensor_sample_sleep(uint8_t conversions);
+
+/**
+ * @brief Measures the noise of the field sensors in the given mode
+ * @details Takes #SENSOR_NOISE_SAMPLES samples of every field sensor and computes their
+ * variance. Busy waits until all samples are taken, the mode is restored afterwards.
+ * @param mode Mode in which the samples should be taken
+ * @param variance Variance of the channels ADC0 to ADC2 in LSB² with 4 fraction bits
+ */
+void sensor_measure_noise(sensor_mode mode, uint16_t *variance);
+
+/**
+ * @brief Reads the newest filtered value of the given channel without waiting for the adc
+ * @param channel Channel on the adc module as defined
+ * @return Output of the filter of the channel
+ */
+uint16_t sensor_scan_value(uint8_t channel);
+
+/**
+ * @brief Checks if the adc converted all field sensors again since the last call
+ * @details The filtered values only change with new samples, so a caller that runs faster than
+ * the adc uses this to take every round of samples only once.
+ * @retval 1 if at least one new round of the field sensors was converted
+ * @retval 0 otherwise
+ */
+uint8_t sensor_take_round(void);
+
+/**
+ * @brief Retrieves how many samples the filter of the given channel currently averages
+ * @param channel Channel on the adc module as defined
+ * @return Length of the window of the boxcar filter
+ */
+uint8_t sensor_get_window(uint8_t channel);
+
+/**
+ * @brief Retrieves the running estimate of the noise of the given channel
+ * @param channel Channel on the adc module as defined
+ * @return Standard deviation of the raw samples in LSB with #FILTER_NOISE_SHIFT fraction bits
+ */
+uint16_t sensor_get_noise(uint8_t channel);
+
+/**
+ * @brief Changes the type of the filter that is used for the given channel
+ * @details The defaults are #SENSOR_FILTER_LINE and #SENSOR_FILTER_BATTERY
+ * @param channel Channel on the adc module as defined
+ * @param type New type of the filter
+ */
+void sensor_filter_select(uint8_t channel, filter_type type);
 
 /**
  * @brief Reads the output signals on the given channel of the adc (analog-digital-converter) module
  * @param channel Channel on the adc module as defined
  * @details We have a 10-bit-ADC, so somewhere in memory we have to read that
- * 10 bits.  Due to this, this function returns a 16-bit-value.
+ * 10 bits.  Due to this, this function returns a 16-bit-value. @n
+ * Busy waits until the conversion is done, the background scan is paused in the meantime.
  * @return Digital value measured
  */
 uint16_t sensor_adc_read(uint8_t channel);
@@ -173,21 +531,49 @@ uint16_t sensor_adc_read_avg(uint8_t channel, uint8_t amount_samples);
 
 /**
  * @brief Reads the state of all field sensors.
+ * @details Uses the values of the background scan, so this never waits on the adc. A sensor
+ * changes its state only if its value crosses the threshold on the other side of the
+ * @ref secCalHys "hysteresis".
  * @retval sensor_state#SENSOR_LEFT
  */
 sensor_state sensor_get_state();
 
 /**
- * @brief Reads the state of the battery and retrieves a percent value of voltage of the battery
- * multiplied by 100
+ * @brief Estimates the lateral position of the line from the analog values of the field sensors.
+ * @details Every value is scaled between the calibrated background and line level of its sensor,
+ * the offset is the centroid of the three scaled values. If no sensor sees the line with at least
+ * #LINE_CONFIDENCE_MIN, the line is reported at #LINE_OFFSET_LOST on the side it was seen last.
+ * @param position Position that is updated
+ */
+void sensor_get_position(line_position *position);
+
+/**
+ * @brief Retrieves a percent value of voltage of the battery multiplied by 100
+ * @details Returns the value that was last computed by the background scan, never waits on the adc.
  * @retval 0 to 100, based on the percent of voltage of the battery multiplied by 100
  */
 uint8_t sensor_get_battery(void);
 
+/**
+ * @brief Retrieves the filtered voltage of the battery
+ * @return Voltage in units of the upper 8 bits of the adc
+ */
+uint8_t sensor_get_battery_voltage(void);
+
+/**
+ * @brief Checks if the battery is low
+ * @retval 1 if the voltage fell below #BATTERY_MIN + #BATTERY_RANGE
+ * @retval 0 otherwise
+ */
+uint8_t sensor_battery_low(void);
+
 /**
  * @brief Initialises the sensor module
  * @details There is ONE single ADC unit on the microcontroller but different "channels"
  * @details The setup of the ADC is done in this method, the MUX is used in the read-function.
+ * Loads the stored calibration, reads the first value of the battery and starts the background
+ * scan in the end.
+ * @sa #sensor_scan_start
  * @sa #sensor_adc_read
  * @sa #sensor_adc_read_avg
  */
@@ -0,0 +1,63 @@
+/**
+ * @file
+ * @author Larson Schneider
+ * @date 17.10.2026
+ * @brief Plain types that are shared by the firmware and the host tools
+ * @version 0.1
+ * @copyright MIT License.
+ *
+ * This header does not include any avr header, so the pure logic that uses these types can also
+ * be compiled for the host, e.g. by the generator of the @ref secDriTable "decision table".
+ */
+#ifndef ROBOT_TYPES_H
+#define ROBOT_TYPES_H
+
+/**
+ * @brief Describes the binary state of the sensors
+ */
+typedef enum {
+    /**
+ * @brief No sensor signal
+ */
+    SENSOR_NONE = 0,
+/**
+ * @brief Left sensor is high
+ */
+    SENSOR_LEFT = 1,
+/**
+ * @brief Center sensor is high
+ */
+    SENSOR_CENTER = 2,
+/**
+ * @brief Right sensor is high
+ */
+    SENSOR_RIGHT = 4,
+/**
+ * @brief All sensors are high
+ */
+    SENSOR_ALL = 7,
+} sensor_state;
+
+
+/**
+ * @brief Drive directions
+ */
+typedef enum {
+    /** @brief No direction, don't drive */
+    DIR_NONE,
+    /** @brief Drive straight forward */
+    DIR_FORWARD,
+    /** @brief Turn right */
+    DIR_RIGHT,
+    /** @brief Turn left */
+    DIR_LEFT,
+    /** @brief Drive straight backward */
+    DIR_BACK,
+} direction;
+
+/** @brief Amount of values of #sensor_state, all combinations of the three bits */
+#define SENSOR_STATE_AMOUNT 8
+/** @brief Amount of values of #direction */
+#define DIRECTION_AMOUNT 5
+
+#endif
@@ -0,0 +1,115 @@
+#include "sensor_calib.h"
+#include "robot_sensor.h"
+
+sensor_calibration calib_current;
+
+/**
+ * @brief Stored calibration
+ */
+static sensor_calibration EEMEM calib_eeprom;
+
+/**
+ * @brief Levels that were measured since #calib_begin
+ */
+static sensor_calibration calib_measured;
+
+/**
+ * @brief If the high rate mode was enabled before the calibration started
+ */
+static uint8_t calib_fast;
+
+/**
+ * @brief Computes the checksum of the given calibration
+ * @param calibration Calibration to check
+ * @return CRC-8 of all bytes before the checksum
+ */
+static uint8_t calib_checksum(const sensor_calibration *calibration) {
+    const uint8_t *bytes = (const uint8_t *) calibration;
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < sizeof(sensor_calibration) - 1; ++i) {
+        crc = _crc8_ccitt_update(crc, bytes[i]);
+    }
+    return crc;
+}
+
+/**
+ * @brief Computes both thresholds of a sensor from its levels
+ * @param calibration Calibration that contains the levels
+ * @param channel Adc channel of the sensor
+ */
+static void calib_compute(sensor_calibration *calibration, uint8_t channel) {
+    uint16_t background = calibration->background[channel];
+    uint16_t contrast = calibration->line[channel] - background;
+    calibration->upper[channel] = background + (uint32_t) contrast * CALIB_UPPER_PERCENT / 100;
+    calibration->lower[channel] = background + (uint32_t) contrast * CALIB_LOWER_PERCENT / 100;
+}
+
+/**
+ * @brief Fills the current calibration with the fixed thresholds
+ * @details The levels are estimated so that the upper threshold lies where the fixed one was.
+ */
+static void calib_defaults(void) {
+    const uint16_t upper[CALIB_SENSOR_AMOUNT] = {SIGNAL_RIGHT_UPPER, SIGNAL_CENTER_UPPER,
+                                                 SIGNAL_LEFT_UPPER};
+    for (uint8_t channel = 0; channel < CALIB_SENSOR_AMOUNT; ++channel) {
+        uint16_t background = upper[channel] / 2;
+        calib_current.background[channel] = background;
+        calib_current.line[channel] =
+                background + (upper[channel] - background) * 100 / CALIB_UPPER_PERCENT;
+        calib_compute(&calib_current, channel);
+        calib_current.upper[channel] = upper[channel];
+    }
+    calib_current.version = CALIB_VERSION;
+    calib_current.checksum = calib_checksum(&calib_current);
+}
+
+uint8_t calib_load(void) {
+    eeprom_read_block(&calib_current, &calib_eeprom, sizeof(sensor_calibration));
+    if (calib_current.version == CALIB_VERSION
+        && calib_current.checksum == calib_checksum(&calib_current)) {
+        return 1;
+    }
+    calib_defaults();
+    return 0;
+}
+
+void calib_begin(void) {
+    calib_fast = sensor_is_fast();
+    sensor_set_fast(0);
+    for (uint8_t channel = 0; channel < CALIB_SENSOR_AMOUNT; ++channel) {
+        calib_measured.background[channel] = UINT16_MAX;
+        calib_measured.line[channel] = 0;
+    }
+}
+
+void calib_end(void) {
+    sensor_set_fast(calib_fast);
+}
+
+void calib_sample(void) {
+    for (uint8_t channel = 0; channel < CALIB_SENSOR_AMOUNT; ++channel) {
+        uint16_t value = sensor_scan_value(channel);
+        if (value < calib_measured.background[channel]) {
+            calib_measured.background[channel] = value;
+        }
+        if (value > calib_measured.line[channel]) {
+            calib_measured.line[channel] = value;
+        }
+    }
+}
+
+uint8_t calib_finish(void) {
+    for (uint8_t channel = 0; channel < CALIB_SENSOR_AMOUNT; ++channel) {
+        uint16_t background = calib_measured.background[channel];
+        uint16_t line = calib_measured.line[channel];
+        if (line <= background || line - background < CALIB_MIN_CONTRAST) {
+            return 0;
+        }
+        calib_compute(&calib_measured, channel);
+    }
+    calib_measured.version = CALIB_VERSION;
+    calib_measured.checksum = calib_checksum(&calib_measured);
+    calib_current = calib_measured;
+    eeprom_update_block(&calib_current, &calib_eeprom, sizeof(sensor_calibration));
+    return 1;
+}
@@ -0,0 +1,123 @@
+/**
+ * @file
+ * @author Larson Schneider
+ * @date 17.10.2026
+ * @brief Calibration of the reflective optical sensors
+ * @version 0.1
+ * @copyright MIT License.
+ *
+ * This module measures the readings of the optical sensors on the line and on the background,
+ * computes the thresholds of every sensor from them and keeps them in the eeprom.
+ */
+/**
+ * @page calib Calibration module
+ * @tableofcontents
+ * Every reflective optical sensor reads a different value on the same surface and the values
+ * change with the lighting of the room. Because of this the thresholds are not fixed but measured.
+ *
+ * @section secCalSweep Sweep
+ * While calibrating the robot turns on the spot over the line, so that every sensor sees the line
+ * and the background at least once. The lowest value a sensor read is its background level and
+ * the highest value is its line level.
+ * @sa #drive_calibrate
+ *
+ * @section secCalHys Hysteresis
+ * Every sensor has two thresholds between its two levels. A sensor only changes to "line" if its
+ * value exceeds the upper threshold (#CALIB_UPPER_PERCENT) and only changes back to "background"
+ * if its value falls below the lower threshold (#CALIB_LOWER_PERCENT). Values in between keep the
+ * last state, so the state no longer flickers if a sensor is right on the edge of the line.
+ *
+ * @section secCalEep Eeprom
+ * The result of a calibration is stored in the eeprom together with a checksum and read again
+ * while the @ref sensor "sensor module" is initialised. If no valid calibration is stored, the
+ * thresholds fall back to #SIGNAL_RIGHT_UPPER, #SIGNAL_CENTER_UPPER and #SIGNAL_LEFT_UPPER.
+ */
+#ifndef SENSOR_CALIB_H
+#define SENSOR_CALIB_H
+
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+
+/** @brief Amount of calibrated sensors, these are the adc channels 0 to 2 */
+#define CALIB_SENSOR_AMOUNT 3
+/** @brief Position of the upper threshold between background (0) and line (100) level */
+#define CALIB_UPPER_PERCENT 60
+/** @brief Position of the lower threshold between background (0) and line (100) level */
+#define CALIB_LOWER_PERCENT 40
+/** @brief Min difference between line and background level that is accepted for a sensor */
+#define CALIB_MIN_CONTRAST 40
+/** @brief Changes if the layout of the stored calibration changes, older ones are ignored */
+#define CALIB_VERSION 1
+
+/**
+ * @brief Levels and thresholds of all sensors, as stored in the eeprom
+ * @details All arrays are indexed by the adc channel of the sensor.
+ */
+typedef struct sensor_calibration {
+    /**
+     * @brief Version of the layout, has to be #CALIB_VERSION
+     */
+    uint8_t version;
+    /**
+     * @brief Value of every sensor above the background
+     */
+    uint16_t background[CALIB_SENSOR_AMOUNT];
+    /**
+     * @brief Value of every sensor above the line
+     */
+    uint16_t line[CALIB_SENSOR_AMOUNT];
+    /**
+     * @brief Value a sensor has to exceed to change to "line"
+     */
+    uint16_t upper[CALIB_SENSOR_AMOUNT];
+    /**
+     * @brief Value a sensor has to fall below to change back to "background"
+     */
+    uint16_t lower[CALIB_SENSOR_AMOUNT];
+    /**
+     * @brief CRC-8 of all previous bytes
+     */
+    uint8_t checksum;
+} sensor_calibration;
+
+/**
+ * @brief Currently used calibration
+ */
+extern sensor_calibration calib_current;
+
+/**
+ * @brief Loads the calibration from the eeprom, uses the default values if there is none or its
+ * checksum does not match.
+ * @retval 1 if a stored calibration was loaded
+ * @retval 0 if the default values are used
+ */
+uint8_t calib_load(void);
+
+/**
+ * @brief Starts a new calibration, forgets the levels measured so far
+ * @details The field sensors are read with 10 bits until #calib_end is called.
+ */
+void calib_begin(void);
+
+/**
+ * @brief Ends the calibration, whether it was finished or not
+ * @details Restores the resolution of the field sensors that was used before #calib_begin
+ */
+void calib_end(void);
+
+/**
+ * @brief Measures the current values of all sensors and keeps the lowest and highest of them
+ */
+void calib_sample(void);
+
+/**
+ * @brief Computes the thresholds from the measured levels, uses and stores them in the eeprom
+ * @details Nothing is changed if one of the sensors did not see enough difference between line
+ * and background (#CALIB_MIN_CONTRAST).
+ * @retval 1 if the calibration was successful
+ * @retval 0 if the contrast was not high enough
+ */
+uint8_t calib_finish(void);
+
+#endif
@@ -0,0 +1,40 @@
+#include "sensor_debounce.h"
+
+void debounce_init(debounce *debouncer, uint8_t count, uint8_t initial) {
+    debouncer->count_0 = 0;
+    debouncer->count_1 = 0;
+    debouncer->count_2 = 0;
+    debouncer->stable = initial;
+    debouncer->rising = 0;
+    debouncer->falling = 0;
+    debounce_set_count(debouncer, count);
+}
+
+void debounce_set_count(debounce *debouncer, uint8_t count) {
+    for (uint8_t i = 0; i < 3; ++i) {
+        debouncer->limit[i] = (count & (1 << i)) ? 0xFF : 0;
+    }
+}
+
+uint8_t debounce_update(debounce *debouncer, uint8_t sample) {
+    uint8_t delta = sample ^ debouncer->stable;
+    // Increment the counters of the differing bits and reset all others
+    uint8_t count_0 = ~debouncer->count_0 & delta;
+    uint8_t count_1 = (debouncer->count_1 ^ debouncer->count_0) & delta;
+    uint8_t count_2 = (debouncer->count_2 ^ (debouncer->count_1 & debouncer->count_0)) & delta;
+    // Counters that equal the sample count in every bit
+    uint8_t reached = delta & ~(count_0 ^ debouncer->limit[0]) & ~(count_1 ^ debouncer->limit[1])
+                      & ~(count_2 ^ debouncer->limit[2]);
+    debouncer->count_0 = count_0 & ~reached;
+    debouncer->count_1 = count_1 & ~reached;
+    debouncer->count_2 = count_2 & ~reached;
+    debouncer->stable ^= reached;
+    debouncer->rising = reached & sample;
+    debouncer->falling = reached & ~sample;
+    return debouncer->stable;
+}
+
+void debounce_hold(debounce *debouncer) {
+    debouncer->rising = 0;
+    debouncer->falling = 0;
+}
@@ -0,0 +1,106 @@
+/**
+ * @file
+ * @author Larson Schneider
+ * @date 17.10.2026
+ * @brief Debouncing of the bits of the sensor state
+ * @version 0.1
+ * @copyright MIT License.
+ *
+ * This module debounces up to eight binary inputs at once with a vertical counter and reports
+ * the stable state together with its rising and falling edges.
+ */
+/**
+ * @page debounce Debounce module
+ * @tableofcontents
+ * A bit of the sensor state only changes if the new value was read for a given amount of samples
+ * in a row, so a short flicker at the edge of the line or on a spot of the track does not reach the
+ * drive and position logic.
+ *
+ * @section secDebVert Vertical Counter
+ * Every input bit has its own counter of the samples that differ from its stable value. Instead of
+ * eight separate counters the bits of all counters are stored in three bytes (planes), the first
+ * byte holds the lowest bit of every counter, the second the middle bit and so on. One sample
+ * increments all counters at once with a few AND and XOR operations, counters of bits that equal
+ * their stable value are reset at the same time. A bit whose counter reached the sample count
+ * flips its stable value. The count is compared in the same bit parallel way, so it can be any
+ * value from 1 to #DEBOUNCE_COUNT_MAX.
+ *
+ * @section secDebEdge Edges
+ * The bits that flipped with the last sample are kept as rising and falling masks, so a caller can
+ * react to the moment a sensor reaches or leaves the line, instead of comparing states itself.
+ * @sa #debounce_update
+ */
+#ifndef SENSOR_DEBOUNCE_H
+#define SENSOR_DEBOUNCE_H
+
+#include <stdint.h>
+
+/** @brief Largest sample count, the counters have three bits */
+#define DEBOUNCE_COUNT_MAX 7
+
+/**
+ * @brief State of a vertical counter debouncer for eight bits
+ */
+typedef struct debounce {
+    /**
+     * @brief Lowest bit of the counter of every input bit
+     */
+    uint8_t count_0;
+    /**
+     * @brief Middle bit of the counter of every input bit
+     */
+    uint8_t count_1;
+    /**
+     * @brief Highest bit of the counter of every input bit
+     */
+    uint8_t count_2;
+    /**
+     * @brief Sample count as masks, every byte is either all ones or all zeros for the
+     * corresponding bit of the count
+     */
+    uint8_t limit[3];
+    /**
+     * @brief Debounced state of the inputs
+     */
+    uint8_t stable;
+    /**
+     * @brief Bits that changed from 0 to 1 with the last sample
+     */
+    uint8_t rising;
+    /**
+     * @brief Bits that changed from 1 to 0 with the last sample
+     */
+    uint8_t falling;
+} debounce;
+
+/**
+ * @brief Resets the debouncer to the given state, without any edges
+ * @param debouncer Debouncer that should be reset
+ * @param count Samples in a row a bit has to differ before it changes, 1 to #DEBOUNCE_COUNT_MAX
+ * @param initial Stable state after the reset
+ */
+void debounce_init(debounce *debouncer, uint8_t count, uint8_t initial);
+
+/**
+ * @brief Changes the amount of samples in a row a bit has to differ before it changes
+ * @param debouncer Debouncer of the inputs
+ * @param count New sample count, 1 to #DEBOUNCE_COUNT_MAX
+ */
+void debounce_set_count(debounce *debouncer, uint8_t count);
+
+/**
+ * @brief Adds a new sample of all inputs and updates the stable state and the edges
+ * @param debouncer Debouncer of the inputs
+ * @param sample Raw state of the inputs
+ * @return Debounced state, also stored in debounce#stable
+ */
+uint8_t debounce_update(debounce *debouncer, uint8_t sample);
+
+/**
+ * @brief Keeps the stable state and the counters for a cycle without a new sample
+ * @details Clears the edges, so an edge is only reported in the cycle of the sample that caused it.
+ * @param debouncer Debouncer of the inputs
+ */
+void debounce_hold(debounce *debouncer);
+
+#endif
@@ -0,0 +1,64 @@
+#include "sensor_estimate.h"
+
+/**
+ * @brief Limits a value to plus minus the given bound
+ * @param value Value to limit
+ * @param limit Largest absolute value
+ * @return Limited value
+ */
+static int32_t estimate_limit(int32_t value, int32_t limit) {
+    if (value > limit) {
+        return limit;
+    }
+    if (value < -limit) {
+        return -limit;
+    }
+    return value;
+}
+
+void estimate_reset(line_estimator *estimator) {
+    estimator->offset = 0;
+    estimator->rate = 0;
+    estimator->valid = 0;
+}
+
+void estimate_update(line_estimator *estimator, int16_t offset, uint8_t seen, int16_t steer,
+                     uint32_t now) {
+    if (estimator->valid && now - estimator->last_time > ESTIMATE_GAP) {
+        estimate_reset(estimator);
+    }
+    if (!estimator->valid) {
+        if (seen) {
+            estimator->offset = (int32_t) offset << ESTIMATE_FRACTION;
+            estimator->valid = 1;
+            estimator->last_time = now;
+            estimator->measure_time = now;
+        }
+        return;
+    }
+    // Prediction, the steering moves the line to the other side
+    uint16_t elapsed = now - estimator->last_time;
+    int32_t moved = (int32_t) steer * ESTIMATE_STEER_GAIN
+                    >> (ESTIMATE_STEER_FRACTION - ESTIMATE_FRACTION);
+    estimator->offset += (estimator->rate - moved) * elapsed;
+    estimator->offset = estimate_limit(estimator->offset,
+                                       (int32_t) ESTIMATE_OFFSET_LIMIT << ESTIMATE_FRACTION);
+    estimator->last_time = now;
+    if (!seen || now == estimator->measure_time) {
+        return;
+    }
+    // Correction with the residual of the measured offset
+    int32_t residual = ((int32_t) offset << ESTIMATE_FRACTION) - estimator->offset;
+    uint16_t interval = now - estimator->measure_time;
+    estimator->measure_time = now;
+    estimator->offset += (residual * ESTIMATE_ALPHA) >> 8;
+    int32_t rate = estimator->rate + ((residual * ESTIMATE_BETA) >> 8) / interval;
+    estimator->rate = (int16_t) estimate_limit(rate,
+                                               (int32_t) ESTIMATE_RATE_LIMIT << ESTIMATE_FRACTION);
+}
+
+int16_t estimate_offset(const line_estimator *estimator, uint8_t lead) {
+    int32_t offset = estimator->offset + (int32_t) estimator->rate * lead;
+    offset = estimate_limit(offset, (int32_t) ESTIMATE_OFFSET_LIMIT << ESTIMATE_FRACTION);
+    return (int16_t) (offset >> ESTIMATE_FRACTION);
+}
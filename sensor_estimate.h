@@ -0,0 +1,119 @@
+/**
+ * @file
+ * @author Larson Schneider
+ * @date 17.10.2026
+ * @brief Estimates the offset of the line and its rate from the sensors and the steering
+ * @version 0.1
+ * @copyright MIT License.
+ *
+ * This module follows the offset of the line with a small alpha beta filter in fixed point, so
+ * the pid controller can use a prediction of the offset instead of the last measured one.
+ */
+/**
+ * @page estimate Line estimator module
+ * @tableofcontents
+ * The offset of the line is computed from the averaged samples of the sensors, so it always lags
+ * behind the robot by a few milliseconds, and once no sensor sees the line it is only known on
+ * which side it was last. The pid controller then reacts to where the line was, not to where it
+ * is, and only starts to steer into a curve after the line already left the center sensor.
+ *
+ * @section secEstModel Model
+ * The estimator follows two values, the offset x of the line and the rate v it moves below the
+ * robot by itself, which is how much the track bends. Steering moves the line as well, so the
+ * difference u of the duty of the left and the right wheel is part of the prediction:
+ * @f[ x \leftarrow x + (v - g u) \Delta t @f]
+ * A positive u turns the robot to the right, which moves the line to the left. The gain g is
+ * #ESTIMATE_STEER_GAIN. Because the steering is part of the model, v only grows if the line moves
+ * more than the steering explains, on a straight it stays close to zero.
+ *
+ * @section secEstUpdate Updates
+ * At most once every millisecond a measured offset corrects the prediction with the residual r:
+ * @f[ x \leftarrow x + \alpha r \qquad v \leftarrow v + \frac{\beta}{\Delta t} r @f]
+ * with #ESTIMATE_ALPHA and #ESTIMATE_BETA. If the line is lost, there is nothing to measure and
+ * the estimator only predicts, so the offset keeps moving into the curve instead of jumping to the
+ * last side. All values have #ESTIMATE_FRACTION fraction bits, an update takes a few
+ * multiplications and one division.
+ * @sa #estimate_update
+ * @sa #estimate_offset
+ */
+#ifndef SENSOR_ESTIMATE_H
+#define SENSOR_ESTIMATE_H
+
+#include <stdint.h>
+
+/** @brief Fraction bits of the offset and the rate in the estimator */
+#define ESTIMATE_FRACTION 8
+/** @brief Share of the residual that corrects the offset, 256 equals one */
+#define ESTIMATE_ALPHA 128
+/** @brief Share of the residual that corrects the rate, 256 equals one */
+#define ESTIMATE_BETA 24
+/**
+ * @brief Offset the line moves per millisecond and per duty the wheels differ, with
+ * #ESTIMATE_STEER_FRACTION fraction bits
+ * @details Turning on the spot with a difference of 400 moves the line by one sensor in about
+ * 65 milliseconds.
+ */
+#define ESTIMATE_STEER_GAIN 40
+/** @brief Fraction bits of #ESTIMATE_STEER_GAIN */
+#define ESTIMATE_STEER_FRACTION 12
+/** @brief Largest offset the estimator follows, two sensors from the center */
+#define ESTIMATE_OFFSET_LIMIT 512
+/** @brief Largest rate of the line in offset per millisecond */
+#define ESTIMATE_RATE_LIMIT 16
+/** @brief Longest gap between two updates in milliseconds that is followed, longer ones restart */
+#define ESTIMATE_GAP 50
+
+/**
+ * @brief State of the estimator
+ */
+typedef struct line_estimator {
+    /**
+     * @brief Estimated offset of the line, with #ESTIMATE_FRACTION fraction bits
+     */
+    int32_t offset;
+    /**
+     * @brief Rate the line moves by itself in offset per millisecond, with #ESTIMATE_FRACTION
+     * fraction bits
+     */
+    int16_t rate;
+    /**
+     * @brief Set once the first offset was measured
+     */
+    uint8_t valid;
+    /**
+     * @brief Time in milliseconds of the last update
+     */
+    uint32_t last_time;
+    /**
+     * @brief Time in milliseconds of the last measured offset
+     */
+    uint32_t measure_time;
+} line_estimator;
+
+/**
+ * @brief Forgets everything, the next measured offset starts the estimator again
+ * @param estimator Estimator to reset
+ */
+void estimate_reset(line_estimator *estimator);
+
+/**
+ * @brief Predicts the offset up to now and corrects it with a measured offset
+ * @param estimator Estimator to update
+ * @param offset Measured offset of the line, ignored if the line is lost
+ * @param seen 1 if the line was seen, 0 to only predict
+ * @param steer Duty of the left wheel minus the duty of the right wheel since the last update
+ * @param now Current time in milliseconds
+ */
+void estimate_update(line_estimator *estimator, int16_t offset, uint8_t seen, int16_t steer,
+                     uint32_t now);
+
+/**
+ * @brief Predicts the offset of the line ahead of the last update
+ * @details Only the rate of the line itself is used, the steering from now on is not known.
+ * @param estimator Estimator to read
+ * @param lead Time in milliseconds to look ahead
+ * @return Predicted offset of the line
+ */
+int16_t estimate_offset(const line_estimator *estimator, uint8_t lead);
+
+#endif
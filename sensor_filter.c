@@ -0,0 +1,128 @@
+#include "sensor_filter.h"
+
+void filter_init(sensor_filter *filter, filter_type type) {
+    for (uint8_t i = 0; i < FILTER_WINDOW_SIZE; ++i) {
+        filter->samples[i] = 0;
+    }
+    filter->sum = 0;
+    filter->iir = 0;
+    filter->noise = 0;
+    filter->output = 0;
+    filter->head = 0;
+    filter->type = type;
+    filter->shift = FILTER_WINDOW_SHIFT_DEFAULT;
+    filter->shift_min = FILTER_WINDOW_SHIFT_DEFAULT;
+    filter->shift_max = FILTER_WINDOW_SHIFT_DEFAULT;
+    filter->target = 1;
+}
+
+/**
+ * @brief Changes the window of the boxcar filter and sums up the samples that are in it
+ * @param filter Filter of the channel
+ * @param shift New window, as shift
+ */
+static void filter_resize(sensor_filter *filter, uint8_t shift) {
+    uint16_t sum = 0;
+    uint8_t index = filter->head;
+    for (uint8_t i = 0; i < (1 << shift); ++i) {
+        index = (index - 1) & (FILTER_WINDOW_SIZE - 1);
+        sum += filter->samples[index];
+    }
+    filter->sum = sum;
+    filter->shift = shift;
+}
+
+void filter_set_adaptive(sensor_filter *filter, uint8_t shift_min, uint8_t shift_max,
+                         uint8_t target) {
+    filter->shift_min = shift_min;
+    filter->shift_max = shift_max;
+    filter->target = target;
+    if (filter->shift < shift_min) {
+        filter_resize(filter, shift_min);
+    } else if (filter->shift > shift_max) {
+        filter_resize(filter, shift_max);
+    }
+}
+
+uint16_t filter_get_noise(const sensor_filter *filter) {
+    // sigma = sqrt(pi) / 2 * mean absolute difference, about 227 / 256
+    return ((uint32_t) filter->noise * 227) >> 8;
+}
+
+/**
+ * @brief Sets the window to the smallest one whose average keeps less noise than the target
+ * @param filter Filter of the channel
+ */
+static void filter_adapt(sensor_filter *filter) {
+    uint16_t sigma = filter_get_noise(filter);
+    // Both sides in LSB² with 8 fraction bits, the average of 2^n samples has 1/2^n the variance
+    uint32_t variance = (uint32_t) sigma * sigma;
+    uint32_t limit = ((uint32_t) filter->target * filter->target) << (2 * FILTER_NOISE_SHIFT);
+    uint8_t needed = 0;
+    while (needed < filter->shift_max && variance > (limit << needed)) {
+        needed++;
+    }
+    if (needed > filter->shift) {
+        filter_resize(filter, needed);
+    } else if (needed + 2 <= filter->shift && filter->shift > filter->shift_min) {
+        // A quarter of the window would be enough, shrink it one step at a time
+        filter_resize(filter, filter->shift - 1);
+    }
+}
+
+/**
+ * @brief Median of the newest #FILTER_MEDIAN_SIZE samples of the window
+ * @param filter Filter of the channel
+ * @return Median of the samples
+ */
+static uint16_t filter_median(const sensor_filter *filter) {
+    uint16_t sorted[FILTER_MEDIAN_SIZE];
+    uint8_t index = filter->head;
+    // Insertion sort, going backwards from the newest sample
+    for (uint8_t i = 0; i < FILTER_MEDIAN_SIZE; ++i) {
+        index = (index - 1) & (FILTER_WINDOW_SIZE - 1);
+        uint16_t value = filter->samples[index];
+        uint8_t j = i;
+        while (j > 0 && sorted[j - 1] > value) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = value;
+    }
+    return sorted[FILTER_MEDIAN_SIZE / 2];
+}
+
+uint16_t filter_push(sensor_filter *filter, uint16_t sample) {
+    uint8_t head = filter->head;
+    uint16_t last = filter->samples[(head - 1) & (FILTER_WINDOW_SIZE - 1)];
+    // Rounded up, so the estimate can decay to zero
+    filter->noise = filter->noise
+                    - ((filter->noise + (1 << FILTER_NOISE_SHIFT) - 1) >> FILTER_NOISE_SHIFT)
+                    + (sample > last ? sample - last : last - sample);
+    // Replace the sample that falls out of the window, the sum is kept up to date without
+    // iterating the window
+    uint8_t oldest = (head - (1 << filter->shift)) & (FILTER_WINDOW_SIZE - 1);
+    filter->sum += sample - filter->samples[oldest];
+    filter->samples[head] = sample;
+    head = (head + 1) & (FILTER_WINDOW_SIZE - 1);
+    filter->head = head;
+    if (head == 0 && filter->shift_min != filter->shift_max) {
+        filter_adapt(filter);
+    }
+    // iir += (sample - iir) / 2^n, with both sides containing the fraction bits
+    filter->iir = filter->iir - (filter->iir >> FILTER_IIR_SHIFT)
+                  + (sample << (FILTER_IIR_FRACTION - FILTER_IIR_SHIFT));
+
+    switch (filter->type) {
+        case FILTER_IIR:
+            filter->output = filter->iir >> FILTER_IIR_FRACTION;
+            break;
+        case FILTER_MEDIAN:
+            filter->output = filter_median(filter);
+            break;
+        default:
+            filter->output = filter->sum >> filter->shift;
+            break;
+    }
+    return filter->output;
+}
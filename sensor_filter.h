@@ -0,0 +1,180 @@
+/**
+ * @file
+ * @author Larson Schneider
+ * @date 17.10.2026
+ * @brief Integer filters for the samples of the adc
+ * @version 0.1
+ * @copyright MIT License.
+ *
+ * This module provides small filters that smooth the raw samples of one adc channel. They only use
+ * integer arithmetic and a fixed amount of memory, so they are cheap enough to be run inside of the
+ * conversion complete interrupt of the @ref sensor "sensor module".
+ */
+/**
+ * @page filter Filter module
+ * @tableofcontents
+ * Every channel of the adc has its own filter which is fed with every new raw sample of the
+ * channel. All filters share the same structure, so the type of a channel can be changed at any
+ * time. No filter uses floating point numbers, the most expensive operation is a shift.
+ *
+ * @section secFilBox Boxcar
+ * Average of the last 2^sensor_filter#shift samples, at most #FILTER_WINDOW_SIZE. The sum of the
+ * window is updated with every sample by adding the new and subtracting the one that falls out of
+ * the window, the average is then only a shift.
+ * @sa #FILTER_BOXCAR
+ *
+ * @section secFilAdapt Adaptive Window
+ * Averaging n samples divides the standard deviation of the noise by sqrt(n), but also delays the
+ * output by n/2 samples. Every filter keeps a running estimate of its noise, the mean absolute
+ * difference of two consecutive samples, which is 2/sqrt(pi) times the standard deviation for white
+ * noise. Once per #FILTER_WINDOW_SIZE samples the window of the boxcar is set to the smallest power
+ * of two that brings the noise of the average below the target of the filter, within its bounds.
+ * It is only shrunk again when a quarter of the window would be enough, so it does not toggle
+ * between two sizes. A step of the signal itself (the edge of the line) raises the estimate only
+ * for a short time, as it decays by 1/2^#FILTER_NOISE_SHIFT with every sample.
+ * @sa #filter_set_adaptive
+ *
+ * @section secFilIir Exponential
+ * An exponential moving average (first order iir filter) that moves by 1/2^#FILTER_IIR_SHIFT of
+ * the difference towards every new sample. The state keeps #FILTER_IIR_FRACTION additional bits,
+ * so small differences are not lost.
+ * @sa #FILTER_IIR
+ *
+ * @section secFilMed Median
+ * Median of the last #FILTER_MEDIAN_SIZE samples. Removes single spikes completely, instead of
+ * spreading them over the window like the averaging filters do.
+ * @sa #FILTER_MEDIAN
+ */
+#ifndef SENSOR_FILTER_H
+#define SENSOR_FILTER_H
+
+#include <stdint.h>
+
+/**
+ * @brief Amount of raw samples kept by every filter
+ * @details Has to be a power of two, it is the window of the boxcar filter.
+ */
+#define FILTER_WINDOW_SIZE 16
+/** @brief Shift that equals a division by #FILTER_WINDOW_SIZE, the largest possible window */
+#define FILTER_WINDOW_SHIFT 4
+/** @brief Window of the boxcar filter after the reset, as shift */
+#define FILTER_WINDOW_SHIFT_DEFAULT 3
+/**
+ * @brief Amount of samples the median filter is taken from
+ * @details Has to be odd and not larger than #FILTER_WINDOW_SIZE
+ */
+#define FILTER_MEDIAN_SIZE 3
+/** @brief Smoothing of the exponential filter, every sample moves it by 1/2^n of the difference */
+#define FILTER_IIR_SHIFT 3
+/** @brief Additional fraction bits of the exponential filter, 10 bit samples fit 6 of them */
+#define FILTER_IIR_FRACTION 6
+/** @brief Smoothing of the noise estimate, every sample moves it by 1/2^n of the difference */
+#define FILTER_NOISE_SHIFT 4
+
+/**
+ * @brief Available types of filters
+ */
+typedef enum {
+    /**
+     * @brief Average of the last samples
+     */
+    FILTER_BOXCAR,
+    /**
+     * @brief Exponential moving average
+     */
+    FILTER_IIR,
+    /**
+     * @brief Median of the last samples
+     */
+    FILTER_MEDIAN
+} filter_type;
+
+/**
+ * @brief State of the filter of one channel
+ */
+typedef struct sensor_filter {
+    /**
+     * @brief Last raw samples, the oldest one is overwritten first
+     */
+    uint16_t samples[FILTER_WINDOW_SIZE];
+    /**
+     * @brief Sum of all samples in the window
+     */
+    uint16_t sum;
+    /**
+     * @brief State of the exponential filter, contains #FILTER_IIR_FRACTION fraction bits
+     */
+    uint16_t iir;
+    /**
+     * @brief Mean absolute difference of two consecutive samples, contains #FILTER_NOISE_SHIFT
+     * fraction bits
+     */
+    uint16_t noise;
+    /**
+     * @brief Filtered value after the last sample
+     */
+    uint16_t output;
+    /**
+     * @brief Index of the sample that is overwritten next
+     */
+    uint8_t head;
+    /**
+     * @brief Type of the filter, as defined in #filter_type
+     */
+    uint8_t type;
+    /**
+     * @brief Window of the boxcar filter, it averages 2^shift samples
+     */
+    uint8_t shift;
+    /**
+     * @brief Smallest window the adaptive window may shrink to, as shift
+     */
+    uint8_t shift_min;
+    /**
+     * @brief Largest window the adaptive window may grow to, as shift. The window is fixed if it
+     * equals sensor_filter#shift_min.
+     */
+    uint8_t shift_max;
+    /**
+     * @brief Standard deviation of the noise in LSB that the average may keep
+     */
+    uint8_t target;
+} sensor_filter;
+
+/**
+ * @brief Resets the given filter and sets its type
+ * @param filter Filter that should be reset
+ * @param type Type of the filter
+ */
+void filter_init(sensor_filter *filter, filter_type type);
+
+/**
+ * @brief Lets the window of the boxcar filter follow the noise of the samples
+ * @details Pass the same shift as minimum and maximum to fix the window.
+ * @param filter Filter of the channel
+ * @param shift_min Smallest window, as shift
+ * @param shift_max Largest window, as shift, at most #FILTER_WINDOW_SHIFT
+ * @param target Standard deviation of the noise in LSB that the average may keep, at least 1
+ */
+void filter_set_adaptive(sensor_filter *filter, uint8_t shift_min, uint8_t shift_max,
+                         uint8_t target);
+
+/**
+ * @brief Estimates the standard deviation of the raw samples
+ * @param filter Filter of the channel
+ * @return Standard deviation in LSB with #FILTER_NOISE_SHIFT fraction bits
+ */
+uint16_t filter_get_noise(const sensor_filter *filter);
+
+/**
+ * @brief Adds a new raw sample to the filter and updates its output
+ * @details The window and the exponential state are updated for every type, so the type can be
+ * switched without a jump in the output. The adaptive window is updated every
+ * #FILTER_WINDOW_SIZE samples.
+ * @param filter Filter of the channel
+ * @param sample New raw sample
+ * @return Filtered value, also stored in sensor_filter#output
+ */
+uint16_t filter_push(sensor_filter *filter, uint16_t sample);
+
+#endif
@@ -0,0 +1,117 @@
+#include "sensor_scope.h"
+
+volatile uint8_t scope_progress = SCOPE_IDLE;
+/**
+ * @brief Packed samples of the capture, two samples in three bytes
+ */
+static uint8_t scope_buffer[SCOPE_BUFFER_SIZE];
+/**
+ * @brief Index of the sample that is written next
+ */
+static volatile uint8_t scope_head = 0;
+/**
+ * @brief Samples written since the scope was armed, stops at #SCOPE_PRE_TRIGGER, or the samples
+ * that are still recorded after the trigger fired
+ */
+static volatile uint8_t scope_count = 0;
+/**
+ * @brief Condition that ends the recording of the history
+ */
+static scope_trigger scope_trigger_current = SCOPE_TRIGGER_NOW;
+
+/**
+ * @brief Reads a sample from the packed buffer
+ * @param index Index of the sample in the ring
+ * @return Sample with its channel in the upper bits
+ */
+static uint16_t scope_read(uint8_t index) {
+    index &= SCOPE_SAMPLE_AMOUNT - 1;
+    const uint8_t *pair = &scope_buffer[(index >> 1) * 3];
+    if (index & 1) {
+        return (pair[1] >> 4) | ((uint16_t) pair[2] << 4);
+    }
+    return pair[0] | ((uint16_t) (pair[1] & 0x0F) << 8);
+}
+
+void scope_arm(scope_trigger trigger) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        scope_trigger_current = trigger;
+        scope_head = 0;
+        scope_count = 0;
+        scope_progress = SCOPE_ARMED;
+    }
+}
+
+void scope_push(uint8_t channel, uint16_t sample) {
+    uint8_t head = scope_head;
+    uint16_t value = sample | ((uint16_t) channel << SCOPE_CHANNEL_SHIFT);
+    uint8_t *pair = &scope_buffer[(head >> 1) * 3];
+    if (head & 1) {
+        pair[1] = (pair[1] & 0x0F) | (uint8_t) (value << 4);
+        pair[2] = value >> 4;
+    } else {
+        pair[0] = (uint8_t) value;
+        pair[1] = (pair[1] & 0xF0) | (value >> 8);
+    }
+    scope_head = (head + 1) & (SCOPE_SAMPLE_AMOUNT - 1);
+    if (scope_progress == SCOPE_TRIGGERED) {
+        if (--scope_count == 0) {
+            scope_progress = SCOPE_DONE;
+        }
+    } else if (scope_count < SCOPE_PRE_TRIGGER) {
+        scope_count++;
+    }
+}
+
+void scope_update(const debounce *sensors) {
+    if (scope_progress != SCOPE_ARMED || scope_count < SCOPE_PRE_TRIGGER) {
+        return;
+    }
+    uint8_t fire;
+    switch (scope_trigger_current) {
+        case SCOPE_TRIGGER_CHANGE:
+            fire = sensors->rising | sensors->falling;
+            break;
+        case SCOPE_TRIGGER_LOST:
+            fire = sensors->falling && sensors->stable == 0;
+            break;
+        default:
+            fire = 1;
+            break;
+    }
+    if (!fire) {
+        return;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        scope_count = SCOPE_SAMPLE_AMOUNT - SCOPE_PRE_TRIGGER;
+        scope_progress = SCOPE_TRIGGERED;
+    }
+}
+
+uint8_t scope_is_done(void) {
+    return scope_progress == SCOPE_DONE;
+}
+
+void scope_dump(uint8_t fast) {
+    char s[sizeof("SCOPE 256 256 2 1\n")];
+    sprintf_P(s, PSTR("SCOPE %u %u %u %u\n"), SCOPE_SAMPLE_AMOUNT, SCOPE_PRE_TRIGGER,
+              scope_trigger_current, fast);
+    usart_print(s);
+    // The oldest sample is the one that would be overwritten next
+    uint8_t index = scope_head;
+    uint16_t crc = 0;
+    for (uint16_t i = 0; i < SCOPE_SAMPLE_AMOUNT; i += 2) {
+        uint16_t first = scope_read(index++);
+        uint16_t second = scope_read(index++);
+        uint8_t bytes[3] = {(uint8_t) first,
+                            (uint8_t) ((first >> 8) | (second << 4)),
+                            (uint8_t) (second >> 4)};
+        for (uint8_t j = 0; j < 3; ++j) {
+            crc = _crc_xmodem_update(crc, bytes[j]);
+            usart_transmit_byte(bytes[j]);
+        }
+    }
+    usart_transmit_byte((uint8_t) crc);
+    usart_transmit_byte(crc >> 8);
+    scope_progress = SCOPE_IDLE;
+}
@@ -0,0 +1,144 @@
+/**
+ * @file
+ * @author Larson Schneider
+ * @date 17.10.2026
+ * @brief Triggered capture of the raw samples of the adc
+ * @version 0.1
+ * @copyright MIT License.
+ *
+ * This module records the raw samples of all channels of the background scan into a buffer in the
+ * sram and sends them to the host as one binary block once a trigger fired.
+ */
+/**
+ * @page scope Scope module
+ * @tableofcontents
+ * The serial connection is far too slow to send every raw sample while driving, only the state of
+ * the sensors is sent. The scope records the samples of ADC0 to ADC3 at the full rate of the adc
+ * instead and sends them afterwards, like the single shot mode of an oscilloscope.
+ *
+ * @section secScoRec Recording
+ * Once armed, the conversion complete interrupt writes every raw sample into a ring buffer of
+ * #SCOPE_SAMPLE_AMOUNT samples, so the buffer always holds the newest samples. When the trigger
+ * fires, another #SCOPE_SAMPLE_AMOUNT - #SCOPE_PRE_TRIGGER samples are recorded and the capture is
+ * done, so the first #SCOPE_PRE_TRIGGER samples show what happened before the trigger. The trigger
+ * is only checked after the buffer contains that much history. Every sample is stored with 12
+ * bits, the 10 bits of the result and the 2 bits of its channel, so two samples share three bytes.
+ *
+ * @section secScoTrig Triggers
+ * The trigger is checked every cycle of the run loop with the debounced state of the sensors.
+ * - #SCOPE_TRIGGER_CHANGE fires on any edge of a sensor.
+ * - #SCOPE_TRIGGER_LOST fires once the last sensor loses the line.
+ * - #SCOPE_TRIGGER_NOW fires as soon as the history is recorded.
+ *
+ * @section secScoDump Dump
+ * Sending the buffer blocks the cpu for about half a second, so it is only sent while the robot
+ * does not drive on the track. The dump starts with the text line
+ * `SCOPE <samples> <pre trigger> <trigger> <high rate>` followed by the packed samples from the
+ * oldest to the newest one and the CRC-16 (XMODEM) of the packed samples, low byte first. Two
+ * samples a and b are packed as `a[7:0]`, `b[3:0] a[11:8]`, `b[11:4]`, where bits 11 and 10 are
+ * the channel.
+ * @sa #scope_dump
+ */
+#ifndef SENSOR_SCOPE_H
+#define SENSOR_SCOPE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <util/atomic.h>
+#include <util/crc16.h>
+#include "sensor_debounce.h"
+#include "usart.h"
+
+/**
+ * @brief Amount of samples in one capture, has to be a power of two and at most 256
+ * @details At the default rate of the adc this are about 27 milliseconds.
+ */
+#define SCOPE_SAMPLE_AMOUNT 256
+/** @brief Samples in one capture that were taken before the trigger fired */
+#define SCOPE_PRE_TRIGGER 128
+/** @brief Size of the buffer, every sample takes 12 bits */
+#define SCOPE_BUFFER_SIZE (SCOPE_SAMPLE_AMOUNT / 2 * 3)
+/** @brief Bit of the channel in a stored sample */
+#define SCOPE_CHANNEL_SHIFT 10
+
+/**
+ * @brief Conditions that end the recording of the history
+ */
+typedef enum {
+    /**
+     * @brief Any sensor reaches or leaves the line
+     */
+    SCOPE_TRIGGER_CHANGE,
+    /**
+     * @brief No sensor sees the line anymore
+     */
+    SCOPE_TRIGGER_LOST,
+    /**
+     * @brief Right after the history was recorded
+     */
+    SCOPE_TRIGGER_NOW
+} scope_trigger;
+
+/**
+ * @brief Progress of a capture
+ */
+typedef enum {
+    /**
+     * @brief Nothing is recorded
+     */
+    SCOPE_IDLE,
+    /**
+     * @brief The capture is complete and waits to be sent
+     */
+    SCOPE_DONE,
+    /**
+     * @brief The history is recorded, the trigger is checked
+     */
+    SCOPE_ARMED,
+    /**
+     * @brief The trigger fired, the rest of the capture is recorded
+     */
+    SCOPE_TRIGGERED
+} scope_state;
+
+/**
+ * @brief Progress of the current capture, samples are recorded in the states after #SCOPE_ARMED
+ * @details Read by the conversion complete interrupt before it calls #scope_push
+ */
+extern volatile uint8_t scope_progress;
+
+/**
+ * @brief Starts recording the history and waits for the given trigger
+ * @details A capture that was not sent yet is dropped.
+ * @param trigger Condition that ends the recording of the history
+ */
+void scope_arm(scope_trigger trigger);
+
+/**
+ * @brief Adds a raw sample to the capture, only called while recording
+ * @param channel Channel on the adc module the sample was taken from
+ * @param sample Raw 10 bit sample
+ */
+void scope_push(uint8_t channel, uint16_t sample);
+
+/**
+ * @brief Checks the trigger with the debounced state of the sensors
+ * @param sensors Debouncer of the sensor state after the last update
+ */
+void scope_update(const debounce *sensors);
+
+/**
+ * @brief Checks if a capture is complete and waits to be sent
+ * @retval 1 if the capture is done
+ * @retval 0 otherwise
+ */
+uint8_t scope_is_done(void);
+
+/**
+ * @brief Sends the complete capture to the host and frees the buffer
+ * @details Blocks until every byte was sent, see @ref secScoDump for the format.
+ * @param fast If the field sensors were read in the high rate mode, only sent to the host
+ */
+void scope_dump(uint8_t fast);
+
+#endif
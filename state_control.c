@@ -18,7 +18,7 @@ void state_show(track_state *state) {
             // Manual check, so we don't have to create a pointer every tick
             if (timers_check_state(state, COUNTER_1_HZ)) {
                 char s[sizeof("Round and round I go, currently round #1")];
-                sprintf(s, "Round and round I go, currently round #%d", round);
+                sprintf_P(s, PSTR("Round and round I go, currently round #%d"), round);
                 usart_print_pretty(s);
             }
             led_sensor(state->sensor_last);
@@ -26,7 +26,7 @@ void state_show(track_state *state) {
         }
         case AC_FROZEN:
             timers_print(state->counters, COUNTER_1_HZ,
-                         "In safe state! Won't react to any instructions! Rescue me!");
+                         PSTR("In safe state! Won't react to any instructions! Rescue me!"));
             if (timers_check_state(state, COUNTER_32_HZ)) {
                 led_chase(&(state->last_led));
             }
@@ -34,14 +34,23 @@ void state_show(track_state *state) {
         case AC_MANUAL:
             led_sensor(state->sensor_last);
             break;
+        case AC_CALIBRATE:
+            if (timers_check_state(state, COUNTER_1_HZ)) {
+                usart_print_pretty_P(PSTR("Calibrating, turning over the line..."));
+            }
+            led_sensor(state->sensor_last);
+            break;
+        case AC_SCRIPT:
+            led_sensor(state->sensor_last);
+            break;
         case AC_RETURN_HOME:
             timers_print(state->counters, COUNTER_1_HZ,
-                         "Returning home, will reset me there");
+                         PSTR("Returning home, will reset me there"));
             led_sensor(state->sensor_last);
             break;
         case AC_PAUSE:
             timers_print(state->counters, COUNTER_1_HZ,
-                         "Pause .... zzzZZZzzzZZZzzz .... wake me up with P again");
+                         PSTR("Pause .... zzzZZZzzzZZZzzz .... wake me up with P again"));
             if (timers_check_state(state, COUNTER_2_HZ)) {
                 led_chase(&(state->last_led));
             }
@@ -49,15 +58,15 @@ void state_show(track_state *state) {
         case AC_WAIT:
             if ((state->pos) == POS_START_FIELD) {
                 timers_print(state->counters, COUNTER_1_HZ,
-                             "On the starting field. Waiting for your instructions..."
-                             " Send ? for help.");
+                             PSTR("On the starting field. Waiting for your instructions..."
+                                  " Send ? for help."));
                 if (timers_check_state(state, COUNTER_10_HZ)) {
                     led_blink(&(state->last_led));
                 }
             } else {
                 timers_print(state->counters, COUNTER_1_HZ,
-                             "Not on the starting field. Place me there please... "
-                             "Send ? for help.");
+                             PSTR("Not on the starting field. Place me there please... "
+                                  "Send ? for help."));
                 led_sensor(state->sensor_last);
             }
             break;
@@ -69,37 +78,302 @@ void state_show(track_state *state) {
 void state_print_help(const track_state *state) {
     //Only print help text if S was not received once
     if (state->has_driven_once) {
-        usart_println("Currently on track, no help is given if the robot already "
-                      "started driving!");
+        usart_println_P(PSTR("Currently on track, no help is given if the robot already "
+                             "started driving!"));
         return;
     }
     if (state->pos == POS_START_FIELD) {
-        usart_println("On the starting field the following actions are valid:");
-        usart_println(" - S: 3 Rounds");
-        usart_println(" - P: Pause");
-        usart_println(" - C: Home");
+        usart_println_P(PSTR("On the starting field the following actions are valid:"));
+        usart_println_P(PSTR(" - S: 3 Rounds"));
+        usart_println_P(PSTR(" - P: Pause"));
+        usart_println_P(PSTR(" - C: Home"));
     } else {
-        usart_println("Not on the starting field the following actions are valid:");
+        usart_println_P(PSTR("Not on the starting field the following actions are valid:"));
+    }
+    usart_println_P(PSTR(" - X: Safe State / Freeze"));
+    usart_println_P(PSTR(" - R: Reset"));
+    usart_println_P(PSTR(" - ?: Help"));
+    usart_println_P(PSTR(" - K: Calibrate sensors (place me over the line)"));
+    usart_println_P(PSTR(" - V: Measure the noise of the sensors"));
+    usart_println_P(PSTR(" - Z: Switch the sampling mode (background, sleep, pwm synchronized)"));
+    usart_println_P(PSTR(" - F: Toggle reading the sensors with 8 bits at a high rate"));
+    usart_println_P(PSTR(" - H: Measure every pwm mode (place me over the line)"));
+    usart_println_P(PSTR(" - G: Print and reset the written and skipped motor commands"));
+    usart_println_P(PSTR(" - U: Upload a script of moves, e.g. UW150,500 A120,200 S0,300"));
+    usart_println_P(PSTR(" - J: Run the uploaded script"));
+    usart_println_P(PSTR(" - =: Set a drive parameter, followed by its key and value"));
+    usart_println_P(PSTR(" -- L: Logic, 0 for the sensor moves and 1 for the pid controller"));
+    usart_println_P(PSTR(" -- P, I, D: Gains of the pid controller, 256 equals 1"));
+    usart_println_P(PSTR(" -- V: Base duty of the pid controller"));
+    usart_println_P(PSTR(" -- R: Change of the duty per millisecond, 0 turns the ramp off"));
+    usart_println_P(PSTR(" -- M: Motor pwm, 0 fast, 1 phase correct, 2 high frequency"));
+    usart_println_P(PSTR(" -- T: 1 drives faster on the straights learned in round 1"));
+    usart_println_P(PSTR(" -- C: 1 sets the speed from the live classification of the track"));
+    usart_println_P(PSTR(" -- B: 1 scales the duty with the voltage of the battery"));
+    usart_println_P(PSTR(" -- N: Battery voltage the duties are meant for, 20 to 255"));
+    usart_println_P(PSTR(" -- E: Milliseconds the pid controller looks ahead, 0 turns it off"));
+    usart_println_P(PSTR(" -- S: Split event, 0 none, 1 sharp curve, 2 straight, 3 line lost"));
+    usart_println_P(PSTR(" -- K: Duty of the active brake, 0 lets the wheels coast"));
+    usart_println_P(PSTR(" - O: Capture the raw samples, followed by the trigger"));
+    usart_println_P(PSTR(" -- C: On any change of a sensor"));
+    usart_println_P(PSTR(" -- L: When the line is lost"));
+    usart_println_P(PSTR(" -- I: Immediately"));
+    usart_println_P(PSTR(" - M: Manual drive"));
+    usart_println_P(PSTR(" -- W: Drive forward"));
+    usart_println_P(PSTR(" -- B: Drive backwards"));
+    usart_println_P(PSTR(" -- A: Drive left"));
+    usart_println_P(PSTR(" -- 1, 2, 3: Slow, normal or fast, the keys have to be repeated"));
+    usart_print_pretty_P(PSTR(" -- D: Drive right"));
+}
+
+/**
+ * @brief Retrieves the name of a sampling mode
+ * @param mode Sampling mode
+ * @return Name in the program memory
+ */
+static const char *state_sensor_mode_name(sensor_mode mode) {
+    switch (mode) {
+        case SENSOR_MODE_SLEEP:
+            return PSTR("sleep");
+        case SENSOR_MODE_PWM_SYNC:
+            return PSTR("pwm");
+        default:
+            return PSTR("scan");
+    }
+}
+
+void state_print_noise(void) {
+    const sensor_mode modes[] = {SENSOR_MODE_SCAN, SENSOR_MODE_SLEEP, SENSOR_MODE_PWM_SYNC};
+    uint16_t variance[SENSOR_LINE_AMOUNT];
+    usart_println_P(PSTR("Noise of the sensors (variance in LSB^2):"));
+    for (uint8_t i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i) {
+        sensor_measure_noise(modes[i], variance);
+        char s[sizeof(" - scan : right 4095.99, center 4095.99, left 4095.99")];
+        // Variance has 4 fraction bits, print them as two decimals
+        sprintf_P(s, PSTR(" - %-5S: right %u.%02u, center %u.%02u, left %u.%02u"),
+                  state_sensor_mode_name(modes[i]),
+                  variance[ADMUX_CHN_ADC0] >> 4, (variance[ADMUX_CHN_ADC0] & 15) * 100 / 16,
+                  variance[ADMUX_CHN_ADC1] >> 4, (variance[ADMUX_CHN_ADC1] & 15) * 100 / 16,
+                  variance[ADMUX_CHN_ADC2] >> 4, (variance[ADMUX_CHN_ADC2] & 15) * 100 / 16);
+        usart_println(s);
+    }
+    char s[sizeof(" - window: right 16, center 16, left 16")];
+    sprintf_P(s, PSTR(" - window: right %u, center %u, left %u"),
+              sensor_get_window(ADMUX_CHN_ADC0), sensor_get_window(ADMUX_CHN_ADC1),
+              sensor_get_window(ADMUX_CHN_ADC2));
+    usart_println(s);
+    usart_print("\n");
+}
+
+/**
+ * @brief Retrieves the name of a pwm mode
+ * @param mode Pwm mode
+ * @return Name in the program memory
+ */
+static const char *state_pwm_mode_name(pwm_mode mode) {
+    switch (mode) {
+        case PWM_MODE_PHASE_CORRECT:
+            return PSTR("phase");
+        case PWM_MODE_HIGH_FREQUENCY:
+            return PSTR("high");
+        default:
+            return PSTR("fast");
+    }
+}
+
+void state_print_pwm(void) {
+    pwm_mode old_mode = timers_get_pwm_mode();
+    uint8_t old_ramp = output_get_ramp();
+    uint16_t variance[SENSOR_LINE_AMOUNT];
+    output_set_ramp(0);
+    usart_println_P(PSTR("PWM modes (smallest duty that turns me, noise while stalled in LSB^2):"));
+    for (uint8_t mode = 0; mode < PWM_MODE_AMOUNT; ++mode) {
+        timers_set_pwm_mode(mode);
+        // Turn in both directions one after another, so I end up close to where I started
+        uint8_t min_duty = motor_find_min_duty(mode & 1);
+        // The motors draw current below the smallest duty, but the robot stands still
+        uint8_t stall = min_duty * 3 / 4;
+        motor_set_wheels(stall, -stall);
+        sensor_measure_noise(SENSOR_MODE_SCAN, variance);
+        // The same stall with every sample at the phase of the overflow, see secSync
+        uint16_t synced[SENSOR_LINE_AMOUNT];
+        sensor_measure_noise(SENSOR_MODE_PWM_SYNC, synced);
+        motor_drive_stop();
+        char s[sizeof(" - phase: 7812 Hz, duty 255, right 4095.99, center 4095.99, left 4095.99")];
+        sprintf_P(s, PSTR(" - %-5S: %u Hz, duty %u, right %u.%02u, center %u.%02u, left %u.%02u"),
+                  state_pwm_mode_name(mode), timers_get_pwm_setting()->frequency, min_duty,
+                  variance[ADMUX_CHN_ADC0] >> 4, (variance[ADMUX_CHN_ADC0] & 15) * 100 / 16,
+                  variance[ADMUX_CHN_ADC1] >> 4, (variance[ADMUX_CHN_ADC1] & 15) * 100 / 16,
+                  variance[ADMUX_CHN_ADC2] >> 4, (variance[ADMUX_CHN_ADC2] & 15) * 100 / 16);
+        usart_println(s);
+        sprintf_P(s, PSTR("   synced: right %u.%02u, center %u.%02u, left %u.%02u"),
+                  synced[ADMUX_CHN_ADC0] >> 4, (synced[ADMUX_CHN_ADC0] & 15) * 100 / 16,
+                  synced[ADMUX_CHN_ADC1] >> 4, (synced[ADMUX_CHN_ADC1] & 15) * 100 / 16,
+                  synced[ADMUX_CHN_ADC2] >> 4, (synced[ADMUX_CHN_ADC2] & 15) * 100 / 16);
+        usart_println(s);
+    }
+    timers_set_pwm_mode(old_mode);
+    output_set_ramp(old_ramp);
+    usart_print("\n");
+}
+
+void state_print_output(void) {
+    output_stats stats;
+    output_get_stats(&stats);
+    char s[sizeof("Motor commands: written 4294967295, skipped 4294967295")];
+    sprintf_P(s, PSTR("Motor commands: written %lu, skipped %lu"), stats.written,
+              stats.skipped);
+    usart_print_pretty(s);
+    output_reset_stats();
+}
+
+void state_read_parameter(track_state *state) {
+    unsigned char key = usart_receive_byte();
+    int16_t value = usart_receive_number();
+    pid_controller *pid = &state->pid;
+    switch (key) {
+        case 'L':
+            state->logic = value ? DRIVE_LOGIC_PID : DRIVE_LOGIC_SENSOR;
+            pid_reset(pid);
+            break;
+        case 'P':
+            pid->kp = value;
+            break;
+        case 'I':
+            pid->ki = value;
+            break;
+        case 'D':
+            pid->kd = value;
+            break;
+        case 'V':
+            pid->base = value;
+            break;
+        case 'R':
+            output_set_ramp((uint8_t) value);
+            break;
+        case 'M':
+            if (value < 0 || value >= PWM_MODE_AMOUNT) {
+                usart_print_pretty_P(PSTR("Unknown pwm mode, use 0, 1 or 2!"));
+                return;
+            }
+            timers_set_pwm_mode((pwm_mode) value);
+            break;
+        case 'T':
+            state->learning = value != 0;
+            break;
+        case 'C':
+            state->classify = value != 0;
+            classify_reset(&state->classifier, millis);
+            break;
+        case 'B':
+            output_set_compensation(value != 0);
+            break;
+        case 'N':
+            if (value < BATTERY_MIN || value > 255) {
+                usart_print_pretty_P(PSTR("Nominal voltage out of range, use 20 to 255!"));
+                return;
+            }
+            output_set_nominal((uint8_t) value);
+            break;
+        case 'E':
+            state->estimate_lead = (uint8_t) value;
+            estimate_reset(&state->estimator);
+            break;
+        case 'S':
+            if (value < 0 || value >= SPLIT_AMOUNT) {
+                usart_print_pretty_P(PSTR("Unknown split event, use 0, 1, 2 or 3!"));
+                return;
+            }
+            laps_set_split((split_event) value);
+            break;
+        case 'K':
+            if (value < 0 || value > OUTPUT_DUTY_FULL) {
+                usart_print_pretty_P(PSTR("Brake duty out of range, use 0 to 255!"));
+                return;
+            }
+            state->brake_duty = (uint8_t) value;
+            state->brake_time = 0;
+            break;
+        default:
+            usart_print_pretty_P(PSTR("Unknown parameter, use L, P, I, D, V, R, M, T, C, B, N, E, "
+                                      "S or K!"));
+            return;
+    }
+    char s[sizeof("Logic 1, P -32768, I -32768, D -32768, V -32768, R 255, M 2, T 1, C 1, B 1, "
+                  "N 255, E 255, S 3, K 255")];
+    sprintf_P(s, PSTR("Logic %d, P %d, I %d, D %d, V %d, R %u, M %u, T %u, C %u, B %u, N %u, E %u, "
+                      "S %u, K %u"),
+              state->logic, pid->kp, pid->ki, pid->kd, pid->base, output_get_ramp(),
+              timers_get_pwm_mode(), state->learning, state->classify, output_get_compensation(),
+              output_get_nominal(), state->estimate_lead, laps_get_split(), state->brake_duty);
+    usart_print_pretty(s);
+}
+
+void state_read_script(void) {
+    script_clear();
+    uint8_t valid = 1;
+    unsigned char end = ' ';
+    while (end == ' ') {
+        direction dir;
+        unsigned char key = usart_receive_byte();
+        switch (key) {
+            case 'W':
+                dir = DIR_FORWARD;
+                break;
+            case 'A':
+                dir = DIR_LEFT;
+                break;
+            case 'D':
+                dir = DIR_RIGHT;
+                break;
+            case 'B':
+                dir = DIR_BACK;
+                break;
+            case 'S':
+                dir = DIR_NONE;
+                break;
+            default:
+                // The rest of the line must not be read as commands
+                while (key != '\r' && key != '\n') {
+                    key = usart_receive_byte();
+                }
+                script_clear();
+                usart_print_pretty_P(PSTR("Unknown direction in the script, use W, A, B, D or S!"));
+                return;
+        }
+        int16_t duty = usart_receive_number();
+        int16_t duration = usart_receive_number_until(&end);
+        // The whole line is read even if a step is not valid
+        valid &= script_add(dir, duty, duration);
     }
-    usart_println(" - X: Safe State / Freeze");
-    usart_println(" - R: Reset");
-    usart_println(" - ?: Help");
-    usart_println(" - M: Manual drive");
-    usart_println(" -- W: Drive forward");
-    usart_println(" -- B: Drive backwards");
-    usart_println(" -- A: Drive left");
-    usart_print_pretty(" -- D: Drive right");
+    if (!valid) {
+        script_clear();
+        usart_print_pretty_P(PSTR("Script dropped, at most 16 steps with a duty up to 255 and "
+                                  "1 to 30000 ms each!"));
+        return;
+    }
+    char s[sizeof("Script stored: 16 steps, 4294967295 ms, start it with J")];
+    sprintf_P(s, PSTR("Script stored: %u steps, %lu ms, start it with J"), script_get_length(),
+              script_get_planned());
+    usart_print_pretty(s);
 }
 
 void state_on_action_change(track_state *state, action_type oldAction) {
-    if (oldAction == AC_ROUNDS) {
+    if (oldAction == AC_SCRIPT) {
+        script_stop();
+    }
+    if (oldAction == AC_ROUNDS || oldAction == AC_CALIBRATE || oldAction == AC_MANUAL
+        || oldAction == AC_SCRIPT) {
         motor_drive_stop();
     }
+    if (oldAction == AC_CALIBRATE) {
+        calib_end();
+    }
     switch (state->action) {
         case AC_RESET:
-            usart_print_pretty("Will reset myself in 5 seconds. I will forget everything. "
-                               "Make sure to handle me well and take care of my messages when"
-                               " I am back functioning. Thanks!");
+            usart_print_pretty_P(PSTR("Will reset myself in 5 seconds. I will forget everything. "
+                                      "Make sure to handle me well and take care of my messages "
+                                      "when I am back functioning. Thanks!"));
             break;
         case AC_WAIT: //Fallthrough
         case AC_FROZEN: //Fallthrough
@@ -109,6 +383,20 @@ void state_on_action_change(track_state *state, action_type oldAction) {
             break;
         case AC_ROUNDS:
             state->has_driven_once = 1;
+            pid_reset(&state->pid);
+            estimate_reset(&state->estimator);
+            // Search again with the full budget if the line is still lost
+            state->recovery.stage = RECOVER_NONE;
+            break;
+        case AC_MANUAL:
+            state->manual_dir = DIR_NONE;
+            break;
+        case AC_CALIBRATE:
+            state->calib_start = millis;
+            calib_begin();
+            break;
+        case AC_SCRIPT:
+            script_start();
             break;
         default:
             break;
@@ -132,9 +420,16 @@ void state_read_manual_input(track_state *state, unsigned char byte) {
         case 'B':
             state->manual_dir = DIR_BACK;
             break;
+        case '1': //Fallthrough
+        case '2': //Fallthrough
+        case '3':
+            state->manual_level = byte - '1';
+            return;
         default:
-            break;
+            return;
     }
+    // Keeps the robot driving, see #drive_manual
+    state->manual_time = millis;
 }
 
 void state_read_input(track_state *state) {
@@ -149,7 +444,7 @@ void state_read_input(track_state *state) {
     switch (byte) {
         case 'S':
             if ((state->pos) != POS_START_FIELD) {
-                usart_print_pretty("Can't start when not on the starting field!");
+                usart_print_pretty_P(PSTR("Can't start when not on the starting field!"));
                 return;
             }
             state->action = AC_ROUNDS;
@@ -163,14 +458,14 @@ void state_read_input(track_state *state) {
                 break;
             }
             if ((state->action) != AC_ROUNDS) {
-                usart_print_pretty("Not driving on track, can't be paused!");
+                usart_print_pretty_P(PSTR("Not driving on track, can't be paused!"));
                 return;
             }
             state->action = AC_PAUSE;
             break;
         case 'C':
             if (state->action != AC_ROUNDS) {
-                usart_print_pretty("Not driving on track, can't be called home!");
+                usart_print_pretty_P(PSTR("Not driving on track, can't be called home!"));
                 return;
             }
             state->action = AC_RETURN_HOME;
@@ -190,6 +485,93 @@ void state_read_input(track_state *state) {
             }
             state->action = AC_MANUAL;
             break;
+        case 'K':
+            if (state->action != AC_WAIT) {
+                usart_print_pretty_P(PSTR("Can only calibrate while waiting for instructions!"));
+                return;
+            }
+            state->action = AC_CALIBRATE;
+            break;
+        case 'U':
+            if (state->action != AC_WAIT) {
+                usart_print_pretty_P(PSTR("Can only upload a script while waiting for "
+                                          "instructions!"));
+                return;
+            }
+            state_read_script();
+            return;
+        case 'J':
+            if (state->action != AC_WAIT || !script_get_length()) {
+                usart_print_pretty_P(PSTR("Can only run a stored script while waiting for "
+                                          "instructions!"));
+                return;
+            }
+            state->action = AC_SCRIPT;
+            break;
+        case 'V':
+            if (state->action == AC_ROUNDS || state->action == AC_RETURN_HOME) {
+                usart_print_pretty_P(PSTR("Can't measure the noise while driving on track!"));
+                return;
+            }
+            state_print_noise();
+            return;
+        case 'Z':
+            switch (sensor_get_mode()) {
+                case SENSOR_MODE_SCAN:
+                    sensor_set_mode(SENSOR_MODE_SLEEP);
+                    usart_print_pretty_P(PSTR("Sampling the sensors in the noise reduction sleep "
+                                              "mode."));
+                    break;
+                case SENSOR_MODE_SLEEP:
+                    sensor_set_mode(SENSOR_MODE_PWM_SYNC);
+                    usart_print_pretty_P(PSTR("Sampling the sensors synchronized to the motor "
+                                              "pwm."));
+                    break;
+                default:
+                    sensor_set_mode(SENSOR_MODE_SCAN);
+                    usart_print_pretty_P(PSTR("Sampling the sensors in the background."));
+                    break;
+            }
+            return;
+        case 'F':
+            sensor_set_fast(!sensor_is_fast());
+            if (sensor_is_fast()) {
+                usart_print_pretty_P(PSTR("Reading the sensors with 8 bits at a high rate."));
+            } else {
+                usart_print_pretty_P(PSTR("Reading the sensors with 10 bits."));
+            }
+            return;
+        case 'H':
+            if (state->action != AC_WAIT) {
+                usart_print_pretty_P(PSTR("Can only measure the pwm while waiting for "
+                                          "instructions!"));
+                return;
+            }
+            state_print_pwm();
+            return;
+        case 'G':
+            state_print_output();
+            return;
+        case '=':
+            state_read_parameter(state);
+            return;
+        case 'O':
+            switch (usart_receive_byte()) {
+                case 'C':
+                    scope_arm(SCOPE_TRIGGER_CHANGE);
+                    break;
+                case 'L':
+                    scope_arm(SCOPE_TRIGGER_LOST);
+                    break;
+                case 'I':
+                    scope_arm(SCOPE_TRIGGER_NOW);
+                    break;
+                default:
+                    usart_print_pretty_P(PSTR("Unknown trigger, use C, L or I!"));
+                    return;
+            }
+            usart_print_pretty_P(PSTR("Scope armed, waiting for the trigger."));
+            return;
         case 'Y':
             state->ui_connection = UI_CONNECTED;
             return;
@@ -213,20 +595,18 @@ void state_read_input(track_state *state) {
 }
 
 void state_update_position(track_state *trackState) {
-    if (!timers_check_state(trackState, COUNTER_12_HZ)) {
-        return;
-    }
     trackState->last_pos = trackState->pos;
+    const debounce *debouncer = &trackState->sensor_debounce;
     // All sensors on, could be home field
-    if (trackState->sensor_last == SENSOR_ALL) {
-        trackState->homeCache++;
-        if (trackState->homeCache > 2) {
+    if (debouncer->stable == SENSOR_ALL) {
+        if (debouncer->rising) {
+            trackState->home_since = millis;
+        }
+        if (millis - trackState->home_since >= POS_START_FIELD_TIME) {
             trackState->pos = POS_START_FIELD;
-            trackState->homeCache = 3;
         }
         return;
     }
-    trackState->homeCache = 0;
     if (trackState->action == AC_ROUNDS) {
         trackState->pos = POS_TRACK;
     } else {
@@ -237,8 +617,8 @@ void state_update_position(track_state *trackState) {
 void state_send_update(const track_state *trackState) {
     if (trackState->ui_connection == UI_CONNECTED && timers_check_state(trackState,
                                                                         COUNTER_12_HZ)) {
-        char *s = "[(7,7,7,7,1000,7)]\n";
-        sprintf(s, "[(%d,%d,%d,%d,%d,%d)]\n",
+        char s[sizeof("[(7,7,7,7,1000,7,7,7,1125,1)]\n")];
+        sprintf_P(s, PSTR("[(%d,%d,%d,%d,%d,%d,%d,%d,%u,%d)]\n"),
                 // Last sensor state
                 trackState->sensor_last,
                 // Direction of driving
@@ -249,20 +629,53 @@ void state_send_update(const track_state *trackState) {
                 trackState->pos == POS_START_FIELD,
                 // Is manual
                 trackState->action == AC_MANUAL,
-                // Battery voltage in percent times 100
-                sensor_get_battery());
+                // Battery voltage in percent times 100, cached by the sensor module
+                sensor_get_battery(),
+                // Battery low
+                sensor_battery_low(),
+                // Line lost and not found again
+                trackState->recovery.stage == RECOVER_FAILED,
+                // Compensation factor of the duties in percent
+                (uint16_t) (((uint32_t) output_get_factor() * 100) >> 8),
+                // Battery too low to keep the speed of the current command
+                output_is_saturated());
         usart_print(s);
     }
 }
 
+void state_send_scope(const track_state *trackState) {
+    if (!scope_is_done()) {
+        return;
+    }
+    // Sending takes too long to do it while following the line
+    switch (trackState->action) {
+        case AC_ROUNDS:
+        case AC_RETURN_HOME:
+        case AC_CALIBRATE:
+            return;
+        default:
+            scope_dump(sensor_is_fast());
+            break;
+    }
+}
+
 _Noreturn void state_run_loop(track_state *trackState) {
     while (1) {
         state_read_input(trackState);
-        trackState->sensor_current = sensor_get_state();
+        sensor_state sensors = sensor_get_state();
+        if (sensor_take_round()) {
+            trackState->sensor_current = debounce_update(&trackState->sensor_debounce, sensors);
+        } else {
+            // Without new samples the state is the same as before, so it must not count again
+            debounce_hold(&trackState->sensor_debounce);
+        }
         state_update_position(trackState);
+        scope_update(&trackState->sensor_debounce);
+        output_set_voltage(sensor_get_battery_voltage());
         timers_update(trackState->counters);
         state_show(trackState);
         state_send_update(trackState);
+        state_send_scope(trackState);
         action_type action = trackState->action;
         switch (action) {
             case AC_MANUAL: {
@@ -273,6 +686,14 @@ _Noreturn void state_run_loop(track_state *trackState) {
                 drive_home(trackState);
                 break;
             }
+            case AC_CALIBRATE: {
+                drive_calibrate(trackState);
+                break;
+            }
+            case AC_SCRIPT: {
+                drive_script(trackState);
+                break;
+            }
             case AC_ROUNDS: {
                 drive_run(trackState);
                 break;
@@ -25,6 +25,13 @@
  * @section secCycle Working Cycle
  * The work cycle is the run loop of this program. It does actions like reading the input, update
  * the leds, send messages via serial and do the actions that are relative to the entered keys.
+ * @section secPos Position
+ * The state of the sensors is debounced in every cycle in which the adc completed a new round over
+ * the field sensors (see @ref debounce and #sensor_take_round), so the debouncer counts samples and
+ * not cycles of the loop, which can be much faster than the adc. The position reacts to the edges
+ * of the stable state right away. The robot is on the start field once all sensors saw
+ * it for #POS_START_FIELD_TIME, as a crossing or a curve can also turn on all sensors for a moment.
+ * It leaves the start field as soon as one sensor falls off.
  */
 
 #ifndef STATE_CONTROL_H
@@ -39,6 +46,16 @@
 #include "drive_control.h"
 #include "state_control.h"
 #include "led_control.h"
+#include "sensor_debounce.h"
+
+/**
+ * @brief Rounds of samples in a row a bit of the sensor state has to differ before it changes
+ */
+#define SENSOR_DEBOUNCE_COUNT 3
+/**
+ * @brief Time in milliseconds all sensors have to see the start field before it is the position
+ */
+#define POS_START_FIELD_TIME 200
 
 /**
  * @brief Represents the current state to the outside world. For example printing USART message or
@@ -54,6 +71,41 @@ void state_show(track_state *state);
  */
 void state_print_help(const track_state *state);
 
+/**
+ * @brief Measures the noise of the field sensors in every sampling mode and prints it.
+ * @details Busy waits while measuring, the motors keep their current state. Measure in the manual
+ * mode while the wheels turn, to see how much the motors disturb the sensors.
+ */
+void state_print_noise(void);
+
+/**
+ * @brief Measures the smallest duty that turns the wheels and the noise of the sensors while the
+ * motors are stalled in every pwm mode and prints it.
+ * @details Turns the robot a bit in both directions, so it has to stand over the line.
+ * @sa motor_find_min_duty
+ */
+void state_print_pwm(void);
+
+/**
+ * @brief Prints the amount of written and skipped motor commands and resets the counters.
+ * @sa output_get_stats
+ */
+void state_print_output(void);
+
+/**
+ * @brief Reads the key and the value of a drive parameter after a '=' and applies it
+ * @details The keys are L for the drive logic and P, I, D and V for the gains and the base duty of
+ * the pid controller, e.g. "=P96". Prints all parameters afterwards.
+ * @param state Internal state
+ */
+void state_read_parameter(track_state *state);
+
+/**
+ * @brief Reads the steps of a maneuver script after a 'U' and stores them
+ * @details See @ref secScrUpload for the format. The script is dropped if any step is not valid.
+ */
+void state_read_script(void);
+
 /**
  * @brief Applies effects and show state to the outside that depend on the current action.
  * @param oldAction Action that was present before the new state
@@ -74,7 +126,8 @@ void state_read_manual_input(track_state *state, unsigned char byte);
 /**
  * @brief Tries to read an input from the USART, apply the action behind the character if any is
  * defined, send an error message for undefined characters.
- * @details Defined characters are: S, X; P, C, R, ?
+ * @details Defined characters are: S, X; P, C, R, K, V, Z, F, O, =, ?. O reads the trigger of the
+ * scope as a second character, = a drive parameter.
  *
  * @param state Internal state
  */
@@ -83,6 +136,8 @@ void state_read_input(track_state *state);
 /**
  * @brief Updates position of the state. Checks if the robot is: "on the start",
  * "on the track (if already started driving)" or "unknown (on the track but not started)"
+ * @details Called every cycle after the sensor state was debounced, #track_state.last_pos is the
+ * position of the last cycle.
  *
  * @param trackState The currently used state
  */
@@ -95,6 +150,12 @@ void state_update_position(track_state *trackState);
  */
 _Noreturn void state_run_loop(track_state *trackState);
 
+/**
+ * @brief Sends a complete capture of the scope, as soon as the robot does not drive on the track
+ * @param trackState Internal state
+ */
+void state_send_scope(const track_state *trackState);
+
 /**
  * @brief Sends state to the user interface if we are connected to our personal implementation.
  * @param trackState Internal state
@@ -1,4 +1,5 @@
 #include "timers.h"
+#include "drive_script.h"
 
 uint32_t millis = 0;
 /**
@@ -7,6 +8,18 @@ uint32_t millis = 0;
 const uint16_t counter_frequencies[COUNTER_AMOUNT] = {1000 / 1, 1000 / 2,
                                                       1000 / 10, 1000 / 12,
                                                       1000 / 32};
+/**
+ * @brief Settings of timer 0 for every pwm mode, indexed by #pwm_mode
+ */
+static const pwm_setting pwm_settings[PWM_MODE_AMOUNT] = {
+        {TIMER_0_WAVE_MODE, TIMER_0_PRE_SCALE, 1, 1, 976},
+        {TIMER_0_WAVE_MODE_PHASE_CORRECT, TIMER_0_PRE_SCALE, 1, 2, 490},
+        {TIMER_0_WAVE_MODE, TIMER_0_PRE_SCALE_8, 8, 1, 7812}
+};
+/**
+ * @brief Current mode of the pwm of the motors
+ */
+static pwm_mode pwm_mode_current = PWM_MODE_FAST;
 /**
  * @brief Updates counter variables
  *
@@ -14,6 +27,8 @@ const uint16_t counter_frequencies[COUNTER_AMOUNT] = {1000 / 1, 1000 / 2,
  */
 ISR (TIMER1_COMPA_vect) {
         millis++;
+        // Steps of a maneuver script must not depend on the run loop
+        script_tick();
 }
 
 void timers_create(counter *counters) {
@@ -49,7 +64,40 @@ uint8_t timers_check(const counter *counters, counter_def counterDef) {
 
 void timers_print(const counter *counters, counter_def frequency, const char *text) {
     if (timers_check(counters, frequency)) {
-        usart_print_pretty(text);
+        usart_print_pretty_P(text);
+    }
+}
+
+void timers_add_ticks(uint8_t ticks) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        uint16_t count = TIMER_1_COUNTER + ticks;
+        // The timer counts from 0 to the compare value, both inclusive
+        if (count > TIMER_1_COMPARE_VALUE) {
+            count -= TIMER_1_COMPARE_VALUE + 1;
+            // The same as the missed interrupt would have done
+            millis++;
+            script_tick();
+        }
+        TIMER_1_COUNTER = count;
+    }
+}
+
+void timers_wait_pwm_off(void) {
+    // Fast PWM: an output is high from BOTTOM until its compare value, phase correct PWM: an
+    // output is high while the counter is below its compare value on both slopes
+    uint8_t high_until = 0;
+    if (TIMER_0_WAVE & (1 << COM0A1)) {
+        high_until = TIMER_0_COMPARE_RESOLUTION_A;
+    }
+    if ((TIMER_0_WAVE & (1 << COM0B1)) && TIMER_0_COMPARE_RESOLUTION_B > high_until) {
+        high_until = TIMER_0_COMPARE_RESOLUTION_B;
+    }
+    if (!high_until) {
+        return;
+    }
+    uint16_t limit = TIMERS_PWM_WAIT_LIMIT;
+    while (TIMER_0_COUNTER <= high_until && --limit) {
+        // Wait for the low phase, it lasts until the counter overflows
     }
 }
 
@@ -63,13 +111,32 @@ void timers_setup_timer_0(void) {
     // Disable all interrupts
     cli();
     TIMER_0_CONTROL = 0;
-    TIMER_0_CONTROL |= TIMER_0_PRE_SCALE;
+    TIMER_0_CONTROL |= pwm_settings[pwm_mode_current].pre_scale;
     TIMER_0_WAVE = 0;
-    TIMER_0_WAVE |= TIMER_0_WAVE_MODE;
+    TIMER_0_WAVE |= pwm_settings[pwm_mode_current].wave;
     // Re-enable all interrupts
     sei();
 }
 
+void timers_set_pwm_mode(pwm_mode mode) {
+    const pwm_setting *setting = &pwm_settings[mode];
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        pwm_mode_current = mode;
+        TIMER_0_CONTROL = (TIMER_0_CONTROL & ~TIMER_0_PRE_SCALE_MASK) | setting->pre_scale;
+        TIMER_0_WAVE = (TIMER_0_WAVE & ~TIMER_0_WAVE_MODE_MASK) | setting->wave;
+        // Start a fresh period in the new mode
+        TIMER_0_COUNTER = 0;
+    }
+}
+
+pwm_mode timers_get_pwm_mode(void) {
+    return pwm_mode_current;
+}
+
+const pwm_setting *timers_get_pwm_setting(void) {
+    return &pwm_settings[pwm_mode_current];
+}
+
 // timer1
 void timers_setup_timer_1(void) {
     // Disable all interrupts
@@ -38,13 +38,31 @@
  * For more info see datasheet p.142
  * @f[ f = \frac{F\_CPU}{PRESCALER * 2^8}@f]
  *
+ * @subsection secPwmModes PWM Modes
+ * At about 976 Hz the motors whine audibly and every switching edge puts a ripple on the readings
+ * of the sensors, so the timer can run in other modes, selected by #timers_set_pwm_mode at runtime
+ * without touching the compare values or the pins.
+ * - #PWM_MODE_FAST is the fast pwm described above.
+ * - #PWM_MODE_PHASE_CORRECT counts up and down, so a period takes 2 * 255 steps (490 Hz). Both
+ *   outputs are centered on the bottom of the counter, so their edges do not fall together and
+ *   the overflow is in the middle of the on phase.
+ * - #PWM_MODE_HIGH_FREQUENCY is the fast pwm with a pre-scale value of 8 (7.8 kHz), above the
+ *   range the motors can follow mechanically, so the current is smoother and the whine is gone.
+ *
+ * The overflow interrupt of the @ref secOutRamp "ramp" runs once per period, so every mode defines
+ * after how many overflows and by how many steps the ramp moves, to keep its time about the same.
+ * Timer 1 and so the milliseconds are not touched by any mode. The sensor noise and the smallest
+ * duty that still turns the wheels in each mode are measured with `H`.
+ * @f[ f_{phase} = \frac{F\_CPU}{PRESCALER * 510}@f]
+ *
  * @section secTimer1 Timer 1
  * This timer is used for the counters used to check for meet frequency requirements. This timer is
  * a 16-Bit timer and has a pre-scale value set to 64. Here only the compare value A is used and
  * set to 250 together with the defined pre-scale value the timer will meet is compare value every
  * milli second. If the timer value exceeds or equals the compare value an interrupt will be caused
  * wich increases the internal current time value which is used by the @ref secCounter "counter"
- * structures.
+ * structures. The same interrupt moves a running @ref script "maneuver script" on, so its steps do
+ * not depend on the run loop.
  * @f[ f = \frac{F\_CPU}{PRESCALER}@f]
  *
  */
@@ -55,6 +73,7 @@
 #include <stdio.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <util/atomic.h>
 #include "usart.h"
 #include "utility.h"
 
@@ -83,6 +102,42 @@
  * @brief Set waveform generation mode to Fast PWM, frequency = F_CPU / (PRESCALER * 2^8)
  */
 #define TIMER_0_WAVE_MODE ((1 << WGM00) | (1 << WGM01))
+/**
+ * @brief Set waveform generation mode to phase correct PWM, frequency = F_CPU / (PRESCALER * 510)
+ */
+#define TIMER_0_WAVE_MODE_PHASE_CORRECT (1 << WGM00)
+/**
+ * @brief Bits of the waveform generation mode in the timer 0 settings
+ */
+#define TIMER_0_WAVE_MODE_MASK ((1 << WGM00) | (1 << WGM01))
+/**
+ * @brief Set prescaler to 8, used by the high frequency pwm
+ */
+#define TIMER_0_PRE_SCALE_8 (1 << CS01)
+/**
+ * @brief Bits of the prescaler in the timer control register
+ */
+#define TIMER_0_PRE_SCALE_MASK ((1 << CS00) | (1 << CS01) | (1 << CS02))
+/**
+ * @brief Counter value of timer 0
+ */
+#define TIMER_0_COUNTER TCNT0
+/**
+ * @brief Interrupt flags of timer 0
+ */
+#define TIMER_0_INTERRUPT_FLAGS TIFR0
+/**
+ * @brief Flag that is set when timer 0 overflows, cleared by writing a one to it
+ */
+#define TIMER_0_OVERFLOW_FLAG TOV0
+/**
+ * @brief Interrupt mask of timer 0
+ */
+#define TIMER_0_INTERRUPT TIMSK0
+/**
+ * @brief Enables the overflow interrupt of timer 0, once per period of the pwm
+ */
+#define TIMER_0_OVERFLOW_INTERRUPT TOIE0
 /**
  * @brief Counter 0 counter resolution A
  */
@@ -91,6 +146,12 @@
  * @brief Counter 0 counter resolution B
  */
 #define TIMER_0_COMPARE_RESOLUTION_B OCR0B
+/**
+ * @brief Largest amount of polls of the counter while waiting for the low phase of the pwm
+ * @details A poll takes about half a microsecond, so this is a little longer than the period of
+ * the slowest pwm mode, the phase correct one at 490 Hz.
+ */
+#define TIMERS_PWM_WAIT_LIMIT 4200
 
 /**
  * @brief Control Register A and B of timer1
@@ -119,6 +180,58 @@
  * @details 16E6/64=250E3; 250E3/250 => 1000ms
  */
 #define TIMER_1_COMPARE_VALUE 250
+/**
+ * @brief Counter value of timer 1
+ */
+#define TIMER_1_COUNTER TCNT1
+
+/**
+ * @brief Modes of the pwm of the motors on timer 0, see @ref secPwmModes
+ */
+typedef enum {
+    /**
+     * @brief Fast pwm with a pre-scale value of 64, about 976 Hz
+     */
+    PWM_MODE_FAST,
+    /**
+     * @brief Phase correct pwm with a pre-scale value of 64, about 490 Hz
+     */
+    PWM_MODE_PHASE_CORRECT,
+    /**
+     * @brief Fast pwm with a pre-scale value of 8, about 7.8 kHz
+     */
+    PWM_MODE_HIGH_FREQUENCY,
+    /**
+     * @brief Amount of pwm modes
+     */
+    PWM_MODE_AMOUNT
+} pwm_mode;
+
+/**
+ * @brief Settings of timer 0 for one pwm mode
+ */
+typedef struct {
+    /**
+     * @brief Waveform generation bits in #TIMER_0_WAVE
+     */
+    uint8_t wave;
+    /**
+     * @brief Pre-scale bits in #TIMER_0_CONTROL
+     */
+    uint8_t pre_scale;
+    /**
+     * @brief Overflows of the timer per step of the ramp, so a step takes about one millisecond
+     */
+    uint8_t ramp_divider;
+    /**
+     * @brief Multiple of the ramp step that is done per step, for periods longer than a millisecond
+     */
+    uint8_t ramp_scale;
+    /**
+     * @brief Frequency of the pwm in Hz, only used for printing
+     */
+    uint16_t frequency;
+} pwm_setting;
 
 /**
  * @brief Counter variable, which contains a value from 0 to 255. This value represents the
@@ -194,12 +307,30 @@ uint8_t timers_check(const counter *counters, counter_def counterDef);
  * @brief Prints then given message if the frequency requirement is currently meed.
  *
  * @param frequency Frequency on which the given text should be printed.
- * @param text The text that should be printed
+ * @param text The text that should be printed, located in the program memory (see PSTR)
  * @param counters Array of counters, has to be the size of #COUNTER_AMOUNT, and is typically
  * located on the global state
  */
 void timers_print(const counter *counters, counter_def frequency, const char *text);
 
+/**
+ * @brief Adds ticks to timer 1 that were missed while its clock was stopped.
+ * @details Used after sleep modes that stop the clock of the timers, so #millis stays correct.
+ * A millisecond that passed in between also moves a running @ref script "maneuver script" on, so
+ * its steps keep their durations. One tick of timer 1 is 4 microseconds.
+ * @param ticks Missed ticks, less than #TIMER_1_COMPARE_VALUE
+ */
+void timers_add_ticks(uint8_t ticks);
+
+/**
+ * @brief Busy waits until both motor outputs of timer 0 are in the low phase of their duty cycle.
+ * @details Returns immediately if no output is connected to the timer (0% or 100% duty). In every
+ * pwm mode an output is high while the counter is below its compare value. Gives up after
+ * #TIMERS_PWM_WAIT_LIMIT polls of the counter, so a compare value that never lets an output go
+ * low can not block the caller for longer than about one period of the pwm.
+ */
+void timers_wait_pwm_off(void);
+
 /**
  * @brief Setup method for timers module, setups all timers
  */
@@ -208,10 +339,29 @@ void timers_init(void);
 
 /**
  * @brief Sets up timer which is responsible for the duty cycle of the two motors.
- * @details Timer0 on the board
+ * @details Timer0 on the board, in the current pwm mode
 */
 void timers_setup_timer_0(void);
 
+/**
+ * @brief Switches the pwm of the motors to another mode
+ * @details Keeps the compare values and the compare output bits, so the duty stays the same.
+ * @param mode Mode of the pwm
+ */
+void timers_set_pwm_mode(pwm_mode mode);
+
+/**
+ * @brief Retrieves the current mode of the pwm of the motors
+ * @return Mode of the pwm
+ */
+pwm_mode timers_get_pwm_mode(void);
+
+/**
+ * @brief Retrieves the settings of the current mode of the pwm of the motors
+ * @return Settings of the mode
+ */
+const pwm_setting *timers_get_pwm_setting(void);
+
 /**
  * @brief Sets up timer which is responsible for the internal counter.
  * @details Timer1 on the board
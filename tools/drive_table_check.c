@@ -0,0 +1,53 @@
+/**
+ * @file
+ * @author Larson Schneider
+ * @date 17.10.2026
+ * @brief Checks the generated decision table against the rules for every possible input
+ * @version 0.1
+ * @copyright MIT License.
+ *
+ * Runs on the host while building, after drive_table.c was generated. Uses the same lookup as the
+ * firmware and fails the build if any input leads to another direction or other last directions
+ * than the rules in drive_rules.c.
+ */
+#include <stdio.h>
+#include "drive_rules.h"
+#include "drive_table.h"
+
+int main(void) {
+    unsigned int errors = 0;
+    for (int current = 0; current < SENSOR_STATE_AMOUNT; ++current) {
+        if (drive_table_evaluate((sensor_state) current)
+            != rules_evaluate_sensors((sensor_state) current)) {
+            fprintf(stderr, "Evaluate differs for sensors %d\n", current);
+            errors++;
+        }
+        for (int last_state = 0; last_state < SENSOR_STATE_AMOUNT; ++last_state) {
+            for (int last_dir = 0; last_dir < DIRECTION_AMOUNT; ++last_dir) {
+                for (int last_simple = 0; last_simple < DIRECTION_AMOUNT; ++last_simple) {
+                    direction rule_dir = (direction) last_dir;
+                    direction rule_simple = (direction) last_simple;
+                    direction table_dir = (direction) last_dir;
+                    direction table_simple = (direction) last_simple;
+                    direction rule = rules_calc_direction((sensor_state) current,
+                                                          (sensor_state) last_state,
+                                                          &rule_dir, &rule_simple);
+                    direction table = drive_table_direction((sensor_state) current,
+                                                            (sensor_state) last_state,
+                                                            &table_dir, &table_simple);
+                    if (rule != table || rule_dir != table_dir || rule_simple != table_simple) {
+                        fprintf(stderr, "Direction differs for %d %d %d %d\n", current,
+                                last_state, last_dir, last_simple);
+                        errors++;
+                    }
+                }
+            }
+        }
+    }
+    if (errors) {
+        fprintf(stderr, "Decision table does not match the rules, %u errors\n", errors);
+        return 1;
+    }
+    printf("Decision table matches the rules for all %d inputs\n", DRIVE_TABLE_SIZE);
+    return 0;
+}
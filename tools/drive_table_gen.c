@@ -0,0 +1,59 @@
+/**
+ * @file
+ * @author Larson Schneider
+ * @date 17.10.2026
+ * @brief Writes the decision table of the line following to the standard output
+ * @version 0.1
+ * @copyright MIT License.
+ *
+ * Runs on the host while building, every entry is the result of the rules in drive_rules.c for one
+ * combination of inputs. Writes the content of drive_table.c.
+ */
+#include <stdio.h>
+#include "drive_rules.h"
+#include "drive_table.h"
+
+/**
+ * @brief Packs the result of one call of #rules_calc_direction into a table entry
+ * @param current Current sensor state
+ * @param last_state Sensor state in last cycle
+ * @param last_dir Last direction driven before the call
+ * @param last_simple Last simple direction driven before the call
+ * @return Table entry
+ */
+static uint8_t gen_entry(sensor_state current, sensor_state last_state, direction last_dir,
+                         direction last_simple) {
+    direction new_dir = last_dir;
+    direction new_simple = last_simple;
+    direction result = rules_calc_direction(current, last_state, &new_dir, &new_simple);
+    uint8_t entry = (uint8_t) (result | (new_dir << DRIVE_TABLE_LAST_SHIFT));
+    if (new_simple != last_simple) {
+        entry |= 1 << DRIVE_TABLE_SIMPLE_BIT;
+    }
+    return entry;
+}
+
+int main(void) {
+    printf("// Generated by tools/drive_table_gen.c from drive_rules.c, do not edit\n");
+    printf("#include \"drive_table.h\"\n\n");
+    printf("const uint8_t drive_evaluate_table[SENSOR_STATE_AMOUNT] PROGMEM = {");
+    for (int current = 0; current < SENSOR_STATE_AMOUNT; ++current) {
+        printf("%s%d", current ? ", " : "", rules_evaluate_sensors((sensor_state) current));
+    }
+    printf("};\n\n");
+    printf("const uint8_t drive_direction_table[DRIVE_TABLE_SIZE] PROGMEM = {\n");
+    for (int current = 0; current < SENSOR_STATE_AMOUNT; ++current) {
+        for (int last_state = 0; last_state < SENSOR_STATE_AMOUNT; ++last_state) {
+            printf("       ");
+            for (int last_dir = 0; last_dir < DIRECTION_AMOUNT; ++last_dir) {
+                for (int last_simple = 0; last_simple < DIRECTION_AMOUNT; ++last_simple) {
+                    printf(" %3d,", gen_entry((sensor_state) current, (sensor_state) last_state,
+                                              (direction) last_dir, (direction) last_simple));
+                }
+            }
+            printf("\n");
+        }
+    }
+    printf("};\n");
+    return 0;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file
+ * @author Larson Schneider
+ * @date 17.10.2026
+ * @brief Checks the integer filters against the float averaging they replaced
+ * @version 0.1
+ * @copyright MIT License.
+ *
+ * Runs on the host while building. Feeds random 10 bit samples through #filter_push and compares
+ * the boxcar output of every window and the exponential output with the same averages computed in
+ * floating point, like the old firmware did. Fails the build if any output is more than 1 LSB off.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "sensor_filter.h"
+
+/** @brief Amount of random samples fed into every filter */
+#define CHECK_SAMPLES 20000
+/** @brief Largest allowed difference between the integer and the float output in LSB */
+#define CHECK_TOLERANCE 1
+
+/**
+ * @brief Random sample of the adc, either noise around a level or a jump to a new one
+ * @param level Current level of the signal, moved by the jumps
+ * @return Sample from 0 to 1023
+ */
+static uint16_t check_sample(int *level) {
+    if (rand() % 64 == 0) {
+        *level = rand() % 1024;
+    }
+    int sample = *level + rand() % 41 - 20;
+    return (uint16_t) (sample < 0 ? 0 : sample > 1023 ? 1023 : sample);
+}
+
+/**
+ * @brief Compares the boxcar filter with a fixed window to the float average of the same samples
+ * @param shift Window of the filter, as shift
+ * @return Amount of outputs that differ too much
+ */
+static unsigned int check_boxcar(uint8_t shift) {
+    sensor_filter filter;
+    filter_init(&filter, FILTER_BOXCAR);
+    filter_set_adaptive(&filter, shift, shift, 1);
+    uint16_t window[FILTER_WINDOW_SIZE] = {0};
+    uint8_t size = 1 << shift;
+    unsigned int errors = 0;
+    int level = 512;
+    for (unsigned int i = 0; i < CHECK_SAMPLES; ++i) {
+        uint16_t sample = check_sample(&level);
+        window[i % size] = sample;
+        uint16_t output = filter_push(&filter, sample);
+        // The old code summed the samples in a float and truncated the average
+        float sum = 0;
+        for (uint8_t j = 0; j < size; ++j) {
+            sum += window[j];
+        }
+        uint16_t expected = (uint16_t) (sum / (float) size);
+        if (abs((int) output - (int) expected) > CHECK_TOLERANCE) {
+            fprintf(stderr, "Boxcar of %u samples: %u instead of %u at sample %u\n", size,
+                    output, expected, i);
+            errors++;
+        }
+    }
+    return errors;
+}
+
+/**
+ * @brief Compares the exponential filter to the same moving average in floating point
+ * @return Amount of outputs that differ too much
+ */
+static unsigned int check_iir(void) {
+    sensor_filter filter;
+    filter_init(&filter, FILTER_IIR);
+    float average = 0;
+    float alpha = 1.0f / (1 << FILTER_IIR_SHIFT);
+    unsigned int errors = 0;
+    int level = 512;
+    for (unsigned int i = 0; i < CHECK_SAMPLES; ++i) {
+        uint16_t sample = check_sample(&level);
+        uint16_t output = filter_push(&filter, sample);
+        average += alpha * ((float) sample - average);
+        if (fabsf((float) output - average) > CHECK_TOLERANCE) {
+            fprintf(stderr, "Exponential: %u instead of %.2f at sample %u\n", output, average, i);
+            errors++;
+        }
+    }
+    return errors;
+}
+
+int main(void) {
+    unsigned int errors = 0;
+    srand(1);
+    for (uint8_t shift = 0; shift <= FILTER_WINDOW_SHIFT; ++shift) {
+        errors += check_boxcar(shift);
+    }
+    errors += check_iir();
+    if (errors) {
+        fprintf(stderr, "Integer filters do not match the float averaging, %u errors\n", errors);
+        return 1;
+    }
+    printf("Integer filters match the float averaging within %d LSB\n", CHECK_TOLERANCE);
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include "track_laps.h"
+
+/**
+ * @brief Times of the rounds of the current run
+ */
+static lap_record laps_records[LAPS_AMOUNT];
+/**
+ * @brief Index of the round that runs, #LAPS_AMOUNT if none does
+ */
+static uint8_t laps_current = LAPS_AMOUNT;
+/**
+ * @brief Time in milliseconds the current round started
+ */
+static uint32_t laps_start = 0;
+/**
+ * @brief Event that takes the splits
+ */
+static split_event laps_event = SPLIT_NONE;
+/**
+ * @brief Best round, not cleared by the startup code so it survives the reset of the watchdog
+ */
+static struct {
+    /**
+     * @brief #LAPS_MAGIC if the time is valid
+     */
+    uint16_t magic;
+    /**
+     * @brief Time in milliseconds of the best round, zero if there is none
+     */
+    uint32_t time;
+} laps_best __attribute__((section(".noinit")));
+
+void laps_init(void) {
+    if (laps_best.magic != LAPS_MAGIC) {
+        laps_best.magic = LAPS_MAGIC;
+        laps_best.time = 0;
+    }
+}
+
+void laps_begin(uint8_t lap) {
+    if (lap < 1 || lap > LAPS_AMOUNT) {
+        laps_current = LAPS_AMOUNT;
+        return;
+    }
+    if (lap == 1) {
+        for (uint8_t i = 0; i < LAPS_AMOUNT; ++i) {
+            laps_records[i].time = 0;
+            laps_records[i].split_count = 0;
+        }
+    }
+    laps_current = lap - 1;
+    laps_start = millis;
+}
+
+void laps_split(split_event event) {
+    if (event != laps_event || laps_current >= LAPS_AMOUNT) {
+        return;
+    }
+    lap_record *record = &laps_records[laps_current];
+    if (record->split_count < LAPS_SPLIT_AMOUNT) {
+        record->splits[record->split_count++] = millis - laps_start;
+    }
+}
+
+uint32_t laps_end(void) {
+    if (laps_current >= LAPS_AMOUNT) {
+        return 0;
+    }
+    lap_record *record = &laps_records[laps_current];
+    record->time = millis - laps_start;
+    if (!laps_best.time || record->time < laps_best.time) {
+        laps_best.time = record->time;
+    }
+    char s[sizeof("LAP 3 4294967295 4294967295 4")];
+    sprintf_P(s, PSTR("LAP %u %lu %lu %u"), laps_current + 1, record->time, laps_best.time,
+              record->split_count);
+    usart_print(s);
+    for (uint8_t i = 0; i < record->split_count; ++i) {
+        sprintf_P(s, PSTR(" %lu"), record->splits[i]);
+        usart_print(s);
+    }
+    usart_print_P(PSTR("\n"));
+    laps_current = LAPS_AMOUNT;
+    return record->time;
+}
+
+void laps_send_summary(void) {
+    char s[sizeof(" 4294967295")];
+    usart_print_P(PSTR("LAPS"));
+    for (uint8_t i = 0; i < LAPS_AMOUNT; ++i) {
+        sprintf_P(s, PSTR(" %lu"), laps_records[i].time);
+        usart_print(s);
+    }
+    sprintf_P(s, PSTR(" %lu"), laps_best.time);
+    usart_println(s);
+}
+
+void laps_set_split(split_event event) {
+    laps_event = event;
+}
+
+split_event laps_get_split(void) {
+    return laps_event;
+}
+
+uint32_t laps_get_best(void) {
+    return laps_best.time;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file
+ * @author Larson Schneider
+ * @date 17.10.2026
+ * @brief Times the rounds on the track and the splits inside of them
+ * @version 0.1
+ * @copyright MIT License.
+ *
+ * This module takes the time every time the robot leaves the start field and whenever a selected
+ * event happens on the track, keeps the times of every round and the best round, and sends them to
+ * the host as text lines.
+ */
+/**
+ * @page laps Lap timer module
+ * @tableofcontents
+ * Without timestamps two settings of the drive logic can only be compared by watching the robot,
+ * and a part of the track where it loses time can not be found at all.
+ *
+ * @section secLapTimes Times
+ * Every time the robot leaves the start field the current round ends and the next one starts, so
+ * the time of a round is the time between two crossings. Inside a round the first
+ * #LAPS_SPLIT_AMOUNT events of the selected #split_event are stored as splits, the time since the
+ * start of the round. The event is selected with `=S`, by default no splits are taken. The times
+ * of the #LAPS_AMOUNT rounds stay in the sram until the next start. The best round is kept in a
+ * section that is not cleared by the reset after the rounds, so it is still known in the next
+ * run, only switching the robot off forgets it.
+ *
+ * @section secLapSend Telemetry
+ * Sending takes too long to do it while following the line, so the splits are only sent with
+ * their round, right after the robot crossed the start field. The line of a round is
+ * `LAP <round> <time> <best> <splits> <split 1> ...` and after the last round a summary
+ * `LAPS <round 1> <round 2> <round 3> <best>` follows, all times in milliseconds. A best time of
+ * zero means no round was completed yet.
+ * @sa #laps_end
+ */
+#ifndef TRACK_LAPS_H
+#define TRACK_LAPS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "timers.h"
+#include "usart.h"
+
+/** @brief Amount of rounds of a run */
+#define LAPS_AMOUNT 3
+/** @brief Largest amount of splits stored in a round */
+#define LAPS_SPLIT_AMOUNT 4
+/** @brief Marks the best round in the section that survives a reset as valid */
+#define LAPS_MAGIC 0x4C41
+
+/**
+ * @brief Events on the track that take a split
+ */
+typedef enum {
+    /**
+     * @brief No splits are taken
+     */
+    SPLIT_NONE,
+    /**
+     * @brief The classifier labels the track as a sharp curve
+     */
+    SPLIT_SHARP,
+    /**
+     * @brief The classifier labels the track as a straight
+     */
+    SPLIT_STRAIGHT,
+    /**
+     * @brief No sensor sees the line anymore
+     */
+    SPLIT_LOST,
+    /**
+     * @brief Amount of events
+     */
+    SPLIT_AMOUNT
+} split_event;
+
+/**
+ * @brief Times of one round
+ */
+typedef struct lap_record {
+    /**
+     * @brief Time in milliseconds of the whole round, zero while it is not done
+     */
+    uint32_t time;
+    /**
+     * @brief Times in milliseconds since the start of the round
+     */
+    uint32_t splits[LAPS_SPLIT_AMOUNT];
+    /**
+     * @brief Amount of stored splits
+     */
+    uint8_t split_count;
+} lap_record;
+
+/**
+ * @brief Forgets the best round if it was not kept over a reset
+ */
+void laps_init(void);
+
+/**
+ * @brief Starts a round, called when the robot leaves the start field
+ * @param lap Number of the round, 1 to #LAPS_AMOUNT, the first one drops the times of the last run
+ */
+void laps_begin(uint8_t lap);
+
+/**
+ * @brief Takes a split if the event is the selected one and the round has room for it
+ * @param event Event that just happened on the track
+ */
+void laps_split(split_event event);
+
+/**
+ * @brief Ends the current round and sends its times, see @ref secLapSend
+ * @return Time of the round in milliseconds
+ */
+uint32_t laps_end(void);
+
+/**
+ * @brief Sends the times of all rounds and the best round
+ */
+void laps_send_summary(void);
+
+/**
+ * @brief Selects the event that takes the splits
+ * @param event Event, #SPLIT_NONE to take no splits
+ */
+void laps_set_split(split_event event);
+
+/**
+ * @brief Retrieves the event that takes the splits
+ * @return Selected event
+ */
+split_event laps_get_split(void);
+
+/**
+ * @brief Retrieves the time of the best round since the robot was switched on
+ * @return Time in milliseconds, zero if no round was completed yet
+ */
+uint32_t laps_get_best(void);
+
+#endif
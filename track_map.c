@@ -0,0 +1,133 @@
+#include "track_map.h"
+
+/**
+ * @brief One bit per segment, set if the segment is straight
+ */
+static uint8_t map_segments[MAP_SEGMENT_BYTES];
+/**
+ * @brief Amount of recorded segments, only valid with #map_valid
+ */
+static uint16_t map_length = 0;
+/**
+ * @brief Set once a whole round was recorded
+ */
+static uint8_t map_valid = 0;
+/**
+ * @brief Set while the current round is recorded
+ */
+static uint8_t map_recording = 0;
+/**
+ * @brief Estimated distance since the start of the round
+ */
+static uint32_t map_distance = 0;
+/**
+ * @brief Time of the last update
+ */
+static uint32_t map_last_time = 0;
+/**
+ * @brief Milliseconds of the current segment the robot drove forward
+ */
+static uint16_t map_forward_time = 0;
+/**
+ * @brief Milliseconds of the current segment
+ */
+static uint16_t map_segment_time = 0;
+
+/**
+ * @brief Reads a segment from the map
+ * @param segment Index of the segment
+ * @retval 1 if the segment is straight
+ * @retval 0 if it is a curve or behind the end of the map
+ */
+static uint8_t map_read(uint16_t segment) {
+    if (segment >= map_length) {
+        return 0;
+    }
+    return (map_segments[segment >> 3] >> (segment & 7)) & 1;
+}
+
+/**
+ * @brief Stores the finished segment and all segments skipped since then
+ * @param until Index of the current segment, the ones before it are stored
+ */
+static void map_store(uint16_t until) {
+    if (until > MAP_SEGMENT_AMOUNT) {
+        until = MAP_SEGMENT_AMOUNT;
+    }
+    uint8_t straight = map_segment_time && (uint32_t) map_forward_time * 8
+                                           >= (uint32_t) map_segment_time * MAP_STRAIGHT_SHARE;
+    for (; map_length < until; ++map_length) {
+        uint8_t bit = 1 << (map_length & 7);
+        if (straight) {
+            map_segments[map_length >> 3] |= bit;
+        } else {
+            map_segments[map_length >> 3] &= ~bit;
+        }
+    }
+    map_forward_time = 0;
+    map_segment_time = 0;
+}
+
+void map_begin_lap(uint8_t record) {
+    map_distance = 0;
+    map_last_time = millis;
+    map_recording = record;
+    if (record) {
+        map_valid = 0;
+        map_length = 0;
+        map_forward_time = 0;
+        map_segment_time = 0;
+    }
+}
+
+void map_end_lap(void) {
+    if (map_recording) {
+        map_store((map_distance >> MAP_SEGMENT_SHIFT) + 1);
+        map_valid = 1;
+        map_recording = 0;
+    }
+}
+
+void map_update(direction dir) {
+    uint32_t elapsed = millis - map_last_time;
+    map_last_time += elapsed;
+    // Nothing was driven in a longer gap, like a pause
+    if (!elapsed || elapsed > MAP_UPDATE_GAP) {
+        return;
+    }
+    if (map_recording) {
+        // Count the time to the segment it started in, small enough to not matter at the border
+        map_segment_time += elapsed;
+        if (dir == DIR_FORWARD) {
+            map_forward_time += elapsed;
+        }
+    }
+    const motor_frame *command = output_current();
+    int16_t duty = (command->duty_left + command->duty_right) / 2;
+    if (duty <= 0) {
+        return;
+    }
+    uint16_t segment = map_distance >> MAP_SEGMENT_SHIFT;
+    map_distance += (uint32_t) duty * elapsed;
+    uint16_t current = map_distance >> MAP_SEGMENT_SHIFT;
+    if (map_recording && current != segment) {
+        map_store(current);
+    }
+}
+
+uint8_t map_is_straight_ahead(void) {
+    if (!map_valid || map_recording) {
+        return 0;
+    }
+    uint16_t segment = map_distance >> MAP_SEGMENT_SHIFT;
+    for (uint8_t i = 0; i <= MAP_LOOKAHEAD; ++i) {
+        if (!map_read(segment + i)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+uint8_t map_is_valid(void) {
+    return map_valid;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file
+ * @author Larson Schneider
+ * @date 17.10.2026
+ * @brief Map of the straights and curves of the track, learned in the first round
+ * @version 0.1
+ * @copyright MIT License.
+ *
+ * This module records where the robot drove straight during the first round and tells the drive
+ * module in the later rounds if a long enough straight lies ahead to drive faster.
+ */
+/**
+ * @page map Track map module
+ * @tableofcontents
+ * The track is the same in every round, but without a map the robot drives every round as if it
+ * had never seen it before.
+ *
+ * @section secMapDist Distance
+ * The robot has no encoders, so the covered distance is estimated from the commanded duty of the
+ * wheels. Every millisecond the mean of both signed duties is added, so turning on the spot adds
+ * almost nothing. As the estimate grows faster if the robot drives faster, a position in the map
+ * stays at the same place of the track in the faster rounds, which a time since the start would
+ * not. The estimate starts at zero every time the robot leaves the start field.
+ *
+ * @section secMapLearn Learning
+ * In the first round the distance is split into segments of 2^#MAP_SEGMENT_SHIFT units, about
+ * 130 milliseconds at #SPEED_STRAIT. A segment counts as straight if the robot drove forward
+ * during at least #MAP_STRAIGHT_SHARE / 8 of its time, and is stored as a single bit, so the whole
+ * map takes #MAP_SEGMENT_BYTES bytes.
+ *
+ * @section secMapUse Using
+ * In the second and third round the robot drives faster on a straight if the current segment and
+ * the next #MAP_LOOKAHEAD segments are straight as well. This way it slows down again a few
+ * segments before a known curve. Behind the learned end of the round, nothing counts as straight.
+ * @sa #map_is_straight_ahead
+ */
+#ifndef TRACK_MAP_H
+#define TRACK_MAP_H
+
+#include <stdint.h>
+#include "robot_types.h"
+#include "motor_output.h"
+#include "timers.h"
+
+/** @brief Size of a segment in units of the estimated distance as power of two */
+#define MAP_SEGMENT_SHIFT 14
+/** @brief Largest amount of segments of a round */
+#define MAP_SEGMENT_AMOUNT 512
+/** @brief Size of the map, one bit per segment */
+#define MAP_SEGMENT_BYTES (MAP_SEGMENT_AMOUNT / 8)
+/** @brief Eighths of the time of a segment that the robot has to drive forward to count straight */
+#define MAP_STRAIGHT_SHARE 7
+/** @brief Segments after the current one that have to be straight to drive faster */
+#define MAP_LOOKAHEAD 4
+/** @brief Longest time between two updates in milliseconds, longer gaps are not counted */
+#define MAP_UPDATE_GAP 50
+
+/**
+ * @brief Starts a round when the robot leaves the start field
+ * @param record If the round is recorded into the map, dropping the old one
+ */
+void map_begin_lap(uint8_t record);
+
+/**
+ * @brief Ends the current round, a recorded map is valid afterwards
+ * @details The time of the round is taken by the @ref laps "lap timer".
+ */
+void map_end_lap(void);
+
+/**
+ * @brief Adds the distance driven since the last call and records the direction if learning
+ * @details Called every cycle while following the line.
+ * @param dir Direction the robot drove since the last call
+ */
+void map_update(direction dir);
+
+/**
+ * @brief Checks if the robot is on a straight that is long enough to drive faster
+ * @retval 1 if the current and the next #MAP_LOOKAHEAD segments are straight
+ * @retval 0 otherwise, or if no map was learned
+ */
+uint8_t map_is_straight_ahead(void);
+
+/**
+ * @brief Checks if a map was learned
+ * @retval 1 if the first round was recorded completely
+ * @retval 0 otherwise
+ */
+uint8_t map_is_valid(void);
+
+#endif
@@ -0,0 +1,50 @@
+import csv
+import os
+import time
+from typing import Final
+
+LAP_HEADER: Final[str] = "LAP "
+"""Start of the text line with the times of a round"""
+LAPS_HEADER: Final[str] = "LAPS "
+"""Start of the text line with the summary of all rounds"""
+LAPS_PATH: Final[str] = time.strftime("laps_%Y%m%d.csv")
+"""File the rounds of the day are appended to, so settings can be compared afterwards"""
+
+
+def seconds(millis: int) -> str:
+    """Formats a time in milliseconds"""
+    return "%.3f s" % (millis / 1000)
+
+
+class Lap:
+    """Times of one round, sent in the line 'LAP <round> <time> <best> <splits> <split 1> ...'"""
+
+    def __init__(self, line: str):
+        values = [int(value) for value in line.split()[1:]]
+        self.round, self.time, self.best, count = values[:4]
+        self.splits = values[4:4 + count]
+
+    def describe(self) -> str:
+        """Readable text for the console"""
+        text = "Round %d: %s, best %s" % (self.round, seconds(self.time), seconds(self.best))
+        if self.splits:
+            text += ", splits " + ", ".join(seconds(split) for split in self.splits)
+        return text
+
+    def save(self) -> str:
+        """Appends the round to the csv file of the day"""
+        new = not os.path.exists(LAPS_PATH)
+        with open(LAPS_PATH, "a", newline="") as file:
+            writer = csv.writer(file)
+            if new:
+                writer.writerow(["clock", "round", "time", "best", "splits"])
+            writer.writerow([time.strftime("%H:%M:%S"), self.round, self.time, self.best,
+                             " ".join(str(split) for split in self.splits)])
+        return LAPS_PATH
+
+
+def describe_summary(line: str) -> str:
+    """Readable text of the line 'LAPS <round 1> <round 2> <round 3> <best>'"""
+    values = [int(value) for value in line.split()[1:]]
+    rounds, best = values[:-1], values[-1]
+    return "Rounds: %s, best %s" % (", ".join(seconds(value) for value in rounds), seconds(best))
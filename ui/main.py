@@ -10,7 +10,7 @@ import warnings
 from dataclasses import dataclass
 from tkinter import ttk, StringVar, FLAT, LEFT
 from tkinter.scrolledtext import ScrolledText
-from typing import List, Callable, NoReturn, Union
+from typing import List, Callable, NoReturn, Union, Final
 
 from PIL import Image
 from PIL.ImageTk import PhotoImage
@@ -22,6 +22,9 @@ warnings.filterwarnings("ignore", category=DeprecationWarning)
 
 logger = logging.getLogger(__name__)
 
+MANUAL_REPEAT_MS: Final[int] = 50
+"""Interval of the repeated key while a drive button is held, the robot stops 150 ms after the last"""
+
 SENSOR_NONE = 0
 SENSOR_LEFT = 1
 SENSOR_CENTER = 2
@@ -43,14 +46,20 @@ class RobotState:
     home: bool
     manuel: bool
     battery: int
+    battery_low: bool
+    line_lost: bool
+    compensation: int
+    saturated: bool
     connected: bool
 
     def with_connection(self, connected) -> RobotState:
         return RobotState(self.led, self.drive_state, self.action, self.home, self.manuel,
-                          self.battery, connected)
+                          self.battery, self.battery_low, self.line_lost, self.compensation,
+                          self.saturated, connected)
 
 
-STATE_EMPTY = RobotState(SENSOR_NONE, DRIVE_NONE, 0, False, False, 0, False)
+STATE_EMPTY = RobotState(SENSOR_NONE, DRIVE_NONE, 0, False, False, 0, False, False, 100, False,
+                         False)
 
 
 class QueueHandler(logging.Handler):
@@ -165,8 +174,31 @@ class DriveControl:
         self.frm = frm
         self.connection_buttons = []
         self.manuel_buttons = []
+        self.held_key = None
+        self.held_job = None
         self.init_ui()
 
+    def hold(self, button: ttk.Button, key: str):
+        """Sends the key of a drive button and repeats it until the button is released"""
+        if button.instate(['disabled']):
+            return
+        self.held_key = key
+        self.repeat()
+
+    def repeat(self):
+        """Sends the key of the held button again, keeps the robot driving in the manual mode"""
+        if self.held_key is None:
+            return
+        try_send(self.held_key, logger)
+        self.held_job = self.frm.after(MANUAL_REPEAT_MS, self.repeat)
+
+    def release(self, _event=None):
+        """Stops repeating the key, the robot stops on its own shortly after"""
+        self.held_key = None
+        if self.held_job is not None:
+            self.frm.after_cancel(self.held_job)
+            self.held_job = None
+
     def update_state(self, robot_state: RobotState):
         """Update the state of the ui elements"""
         state = tk.NORMAL if robot_state.connected else tk.DISABLED
@@ -187,6 +219,12 @@ class DriveControl:
             self.manuel_buttons.append(button)
             return button
 
+        def add_held(text: str, key: str) -> ttk.Button:
+            button = add_manuel(ttk.Button(self.frm, text=text))
+            button.bind('<ButtonPress-1>', lambda _event: self.hold(button, key))
+            button.bind('<ButtonRelease-1>', self.release)
+            return button
+
         # -S-
         # FPR
         # -H-
@@ -205,16 +243,28 @@ class DriveControl:
         # -W-
         # AMD
         # -B-
-        add_manuel(ttk.Button(self.frm, text="Forward", command=lambda: try_send('W', logger))) \
-            .grid(column=1, row=4)
-        add_manuel(ttk.Button(self.frm, text="Right", command=lambda: try_send('D', logger))) \
-            .grid(column=2, row=5)
+        # The robot only drives while the button is held
+        add_held("Forward", 'W').grid(column=1, row=4)
+        add_held("Right", 'D').grid(column=2, row=5)
         add_connection(ttk.Button(self.frm, text="Manual", command=lambda: try_send('M', logger))) \
             .grid(column=1, row=5)
-        add_manuel(ttk.Button(self.frm, text="Backward", command=lambda: try_send('B', logger))) \
-            .grid(column=1, row=6)
-        add_manuel(ttk.Button(self.frm, text="Left", command=lambda: try_send('A', logger))) \
-            .grid(column=0, row=5)
+        add_held("Backward", 'B').grid(column=1, row=6)
+        add_held("Left", 'A').grid(column=0, row=5)
+        # Speed levels
+        add_manuel(ttk.Button(self.frm, text="Slow", command=lambda: try_send('1', logger))) \
+            .grid(column=0, row=7)
+        add_manuel(ttk.Button(self.frm, text="Normal", command=lambda: try_send('2', logger))) \
+            .grid(column=1, row=7)
+        add_manuel(ttk.Button(self.frm, text="Fast", command=lambda: try_send('3', logger))) \
+            .grid(column=2, row=7)
+        ttk.Label(self.frm, text="").grid(column=1, row=8)
+        # Scope triggers
+        add_connection(ttk.Button(self.frm, text="Scope Change",
+                                  command=lambda: try_send('OC', logger))).grid(column=0, row=9)
+        add_connection(ttk.Button(self.frm, text="Scope Lost",
+                                  command=lambda: try_send('OL', logger))).grid(column=1, row=9)
+        add_connection(ttk.Button(self.frm, text="Scope Now",
+                                  command=lambda: try_send('OI', logger))).grid(column=2, row=9)
 
 
 def create_image(path: str, flip=False) -> PhotoImage:
@@ -228,7 +278,11 @@ def create_image(path: str, flip=False) -> PhotoImage:
 def convert_tuple_state(state_tuple: StateTuple) -> RobotState:
     """Converts the tuple state to a state object"""
     return RobotState(state_tuple[0], state_tuple[1], state_tuple[2], state_tuple[3] > 0,
-                      state_tuple[4] > 0, state_tuple[5], is_connected())
+                      state_tuple[4] > 0, state_tuple[5],
+                      len(state_tuple) > 6 and state_tuple[6] > 0,
+                      len(state_tuple) > 7 and state_tuple[7] > 0,
+                      state_tuple[8] if len(state_tuple) > 8 else 100,
+                      len(state_tuple) > 9 and state_tuple[9] > 0, is_connected())
 
 
 class StateDisplay(tk.Frame):
@@ -254,12 +308,21 @@ class StateDisplay(tk.Frame):
         self.led_left = None
         self.canvas = None
         self.battery = None
+        self.battery_frame = None
+        self.line_lost = None
         self.init_ui()
 
     def update_state(self, state: RobotState):
         """Update the state of the ui elements"""
         # Battery
         self.battery.configure(value=state.battery)
+        text = "Battery (low)" if state.battery_low else "Battery"
+        if state.compensation != 100:
+            text += f" x{state.compensation / 100:.2f}"
+        if state.saturated:
+            text += " (too low to compensate)"
+        self.battery_frame.configure(text=text)
+        self.line_lost.configure(text="Line lost, stopped" if state.line_lost else "")
         # Blue LED
         self.canvas.itemconfig(self.led_left, fill="#05f" if state.led & SENSOR_LEFT else "#667e92")
         # Green LED
@@ -284,10 +347,13 @@ class StateDisplay(tk.Frame):
     def init_ui(self):
         """Creates the ui elements of this control"""
         frm = ttk.Labelframe(self, text="Battery")
+        self.battery_frame = frm
         self.battery = ttk.Progressbar(frm, maximum=100)
         self.battery.pack()
         frm.pack(pady=4, fill=tk.X, expand=1)
         self.battery.pack(pady=4, fill=tk.X, expand=1)
+        self.line_lost = ttk.Label(self, foreground="#c00")
+        self.line_lost.pack()
         self.canvas = tk.Canvas(self)
         self.led_left = self.canvas.create_rectangle(30, 10, 120, 80)
         self.led_center = self.canvas.create_rectangle(150, 10, 240, 80)
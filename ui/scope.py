@@ -0,0 +1,61 @@
+import csv
+import time
+from typing import Final, List, Tuple
+
+SCOPE_HEADER: Final[str] = "SCOPE"
+"""Start of the text line that announces a capture of the scope"""
+SCOPE_TRIGGERS: Final[str] = "CLI"
+"""Triggers of the scope: change of a sensor, line lost, immediately"""
+CHANNEL_NAMES: Final[List[str]] = ["right", "center", "left", "battery"]
+"""Names of the adc channels ADC0 to ADC3"""
+
+Sample = Tuple[int, int]
+"""Channel and raw value of one sample"""
+
+
+class ScopeHeader:
+    """Parameters of a capture, sent in the text line before the samples"""
+
+    def __init__(self, line: str):
+        """Parses the text line 'SCOPE <samples> <pre trigger> <trigger> <high rate>'"""
+        values = [int(value) for value in line.split()[1:]]
+        self.samples, self.pre_trigger, self.trigger, self.fast = values
+
+    def payload_size(self) -> int:
+        """Amount of bytes that follow the text line, including the checksum"""
+        return self.samples // 2 * 3 + 2
+
+
+def crc_xmodem(data: bytes) -> int:
+    """CRC-16 (XMODEM) as computed by the robot"""
+    crc = 0
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+        crc &= 0xFFFF
+    return crc
+
+
+def decode(payload: bytes) -> List[Sample]:
+    """Unpacks the samples of a capture, two samples are packed into three bytes"""
+    data, crc = payload[:-2], payload[-2] | (payload[-1] << 8)
+    if crc_xmodem(data) != crc:
+        raise ValueError("Checksum of the capture does not match")
+    samples = []
+    for i in range(0, len(data), 3):
+        first = data[i] | ((data[i + 1] & 0x0F) << 8)
+        second = (data[i + 1] >> 4) | (data[i + 2] << 4)
+        samples.extend((value >> 10, value & 0x3FF) for value in (first, second))
+    return samples
+
+
+def save(header: ScopeHeader, samples: List[Sample]) -> str:
+    """Writes the samples into a csv file, the index is relative to the trigger"""
+    path = time.strftime("scope_%Y%m%d_%H%M%S.csv")
+    with open(path, "w", newline="") as file:
+        writer = csv.writer(file)
+        writer.writerow(["index", "channel", "value"])
+        for index, (channel, value) in enumerate(samples):
+            writer.writerow([index - header.pre_trigger, CHANNEL_NAMES[channel], value])
+    return path
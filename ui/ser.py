@@ -1,4 +1,5 @@
 import queue
+import re
 import threading
 import time
 from ast import literal_eval as make_tuple
@@ -8,8 +9,13 @@ from typing import Final, Union, Callable, Tuple, NoReturn
 import serial as serial
 from serial import Serial, SerialException, PortNotOpenError, SerialTimeoutException
 
+import laps
+import scope
+
 baud_rate: Final[int] = 9600
 """baudrate of the usert serial connection of the board"""
+MANUAL_LEVELS: Final[str] = "123"
+"""Keys of the speed levels of the manual control"""
 StateTuple = Tuple[int, int, int, int]
 """Type of the tuple that gets send from the robot"""
 UpdateFunction = Callable[[StateTuple], NoReturn]
@@ -64,7 +70,11 @@ class SerialHandler:
                 if self.ser is not None and self.ser.is_open and self.ser.inWaiting() > 0:
                     txt = self.ser.readline().decode().replace('\n', '')
                     # State info
-                    if txt.startswith('[') and txt.endswith(']'):
+                    if txt.startswith(scope.SCOPE_HEADER):
+                        self.read_scope(txt)
+                    elif txt.startswith(laps.LAP_HEADER) or txt.startswith(laps.LAPS_HEADER):
+                        self.read_laps(txt)
+                    elif txt.startswith('[') and txt.endswith(']'):
                         self.read_state(txt)
                     elif txt.startswith('<') and txt.endswith('>'):
                         self.send_byte("Y")
@@ -83,6 +93,33 @@ class SerialHandler:
         except SyntaxError as msg:
             self.logger.log(ERROR, "Failed to read state %s" % msg)
 
+    def read_scope(self, txt: str):
+        """Reads the binary capture of the scope that follows the given header line"""
+        header = scope.ScopeHeader(txt)
+        size = header.payload_size()
+        payload = b''
+        # The robot needs about half a second to send it
+        deadline = time.time() + 2
+        while len(payload) < size and time.time() < deadline:
+            payload += self.ser.read(size - len(payload))
+        try:
+            path = scope.save(header, scope.decode(payload))
+            self.logger.log(INFO, "Scope capture saved to %s" % path)
+        except (ValueError, IndexError) as msg:
+            self.logger.log(ERROR, "Failed to read scope capture: %s" % msg)
+
+    def read_laps(self, txt: str):
+        """Logs the times of a round or the summary of all rounds, rounds are saved as well"""
+        try:
+            if txt.startswith(laps.LAPS_HEADER):
+                self.logger.log(INFO, laps.describe_summary(txt))
+                return
+            lap = laps.Lap(txt)
+            lap.save()
+            self.logger.log(INFO, lap.describe())
+        except (ValueError, IndexError) as msg:
+            self.logger.log(ERROR, "Failed to read lap times: %s" % msg)
+
     def request_state(self):
         """Writes message to the port, that request a state update from the robot"""
         if not ser_handler:
@@ -127,7 +164,15 @@ def try_send(data: str, logger: Logger):
     if not ser_handler:
         logger.log(ERROR, "Not Send: Not Connected")
         return
-    if len(data) > 1 or not data.isalpha() or not data.isupper():
+    # The scope is armed with O followed by its trigger, parameters are set with =, key and value
+    is_scope = len(data) == 2 and data[0] == 'O' and data[1] in scope.SCOPE_TRIGGERS
+    is_parameter = re.fullmatch(r"=[LPIDVRMTCBNESK]-?\d+", data) is not None
+    # Speed levels of the manual control
+    is_level = len(data) == 1 and data in MANUAL_LEVELS
+    # Maneuver scripts, steps of direction, duty and duration separated by a space
+    is_script = re.fullmatch(r"U[WABDS]\d+,\d+( [WABDS]\d+,\d+)*", data) is not None
+    if not is_scope and not is_parameter and not is_level and not is_script \
+            and (len(data) > 1 or not data.isalpha() or not data.isupper()):
         print("Not Send: Invalid character")
         return
     ser_handler.send_byte(data)
@@ -7,6 +7,31 @@ unsigned char usart_receive_byte(void) {
     return UB_DATA;
 }
 
+int16_t usart_receive_number(void) {
+    unsigned char end;
+    return usart_receive_number_until(&end);
+}
+
+int16_t usart_receive_number_until(unsigned char *end) {
+    int16_t number = 0;
+    unsigned char byte = usart_receive_byte();
+    uint8_t negative = byte == '-';
+    if (negative) {
+        byte = usart_receive_byte();
+    }
+    while (byte >= '0' && byte <= '9') {
+        int16_t digit = byte - '0';
+        // Stay at the largest number instead of wrapping around into a valid looking one
+        if (number > (INT16_MAX - digit) / 10) {
+            number = INT16_MAX;
+        } else {
+            number = number * 10 + digit;
+        }
+        byte = usart_receive_byte();
+    }
+    *end = byte;
+    return negative ? -number : number;
+}
 
 uint8_t usart_can_receive() {
     return UB_STATUS & (1 << UB_STATUS_REC_COMPLETE);
@@ -38,6 +63,24 @@ void usart_println(const char *c) {
     usart_print("\n");
 }
 
+void usart_print_P(const char *c) {
+    char data;
+    while ((data = (char) pgm_read_byte(c)) != '\0') {
+        usart_transmit_byte(data);
+        c++;
+    }
+}
+
+void usart_print_pretty_P(const char *c) {
+    usart_println_P(c);
+    usart_print("\n");
+}
+
+void usart_println_P(const char *c) {
+    usart_print_P(c);
+    usart_print("\n");
+}
+
 void usart_init(unsigned long ubrr) {
     // Set baud rate, high byte first
     UB_BAUD_RATE_HIGH = (unsigned char) (ubrr >> 8);
@@ -36,7 +36,9 @@
 #ifndef IESUSART_h
 #define IESUSART_h
 
+#include <stdint.h>
 #include <avr/io.h>
+#include <avr/pgmspace.h>
 
 /// CPU clock speed
 #ifndef F_CPU
@@ -102,6 +104,22 @@
  */
 unsigned char usart_receive_byte(void);
 
+/**
+ * @brief Reads a decimal number with an optional minus sign from the receive buffer
+ * @details Waits for every character, the first character that is no digit ends the number and is
+ * dropped. A number beyond the range of int16_t is read as INT16_MAX or -INT16_MAX, so every
+ * range check of the caller rejects it.
+ * @return received number
+ */
+int16_t usart_receive_number(void);
+
+/**
+ * @brief Reads a decimal number like #usart_receive_number and returns the character that ended it
+ * @param end Set to the first character that is no digit
+ * @return received number
+ */
+int16_t usart_receive_number_until(unsigned char *end);
+
 /**
  * @brief Checks if there is any data to be read
  * @return
@@ -129,6 +147,26 @@ void usart_println(const char *c);
  */
 void usart_print_pretty(const char *c);
 
+/**
+ * @brief Transmitters a string that is located in the program memory (char by char) until '\0’ is
+ * reached
+ * @details Strings in the program memory do not take any of the small dynamic memory, use
+ * PSTR("...") to place them there.
+ */
+void usart_print_P(const char *c);
+
+/**
+ * @brief Transmitters a string that is located in the program memory (char by char) until '\0’ is
+ * reached and adds a new line
+ */
+void usart_println_P(const char *c);
+
+/**
+ * @brief Transmitters a string that is located in the program memory (char by char) until '\0’ is
+ * reached and adds two new lines
+ */
+void usart_print_pretty_P(const char *c);
+
 /**
  * @brief Sets up the USART port (The USART baudrate register)
  * @param ubrr Content to write into the UBRR register
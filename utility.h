@@ -31,6 +31,10 @@
 #include <avr/io.h>
 #include <avr/wdt.h>
 #include "led_control.h"
+#include "robot_types.h"
+#include "sensor_debounce.h"
+#include "drive_classify.h"
+#include "sensor_estimate.h"
 
 /**
  * @brief Amount of counters that are defined in #counter_def
@@ -95,24 +99,118 @@ typedef enum {
     /**
      * @brief The robot gets manual controlled
      */
-    AC_MANUAL
+    AC_MANUAL,
+    /**
+     * @brief The robot turns over the line to calibrate its sensors
+     */
+    AC_CALIBRATE,
+    /**
+     * @brief The robot drives the uploaded maneuver script
+     */
+    AC_SCRIPT
 } action_type;
 
 /**
- * @brief Drive directions
+ * @brief Logic that follows the line while driving on the track
  */
 typedef enum {
-    /** @brief No direction, don't drive */
-    DIR_NONE,
-    /** @brief Drive straight forward */
-    DIR_FORWARD,
-    /** @brief Turn right */
-    DIR_RIGHT,
-    /** @brief Turn left */
-    DIR_LEFT,
-    /** @brief Drive straight backward */
-    DIR_BACK,
-} direction;
+    /**
+     * @brief Selects one of the fixed moves from the state of the sensors
+     */
+    DRIVE_LOGIC_SENSOR,
+    /**
+     * @brief Sets the speed of both wheels continuously with a pid controller
+     */
+    DRIVE_LOGIC_PID
+} drive_logic;
+
+/**
+ * @brief State and parameters of the pid controller that follows the line
+ * @details All gains are fixed point values with 8 fraction bits, the error is the offset of the
+ * line and the output is the difference between the duty of the two wheels.
+ */
+typedef struct pid_controller {
+    /**
+     * @brief Proportional gain
+     */
+    int16_t kp;
+    /**
+     * @brief Integral gain, applied to the sum of the errors of all periods
+     */
+    int16_t ki;
+    /**
+     * @brief Derivative gain, applied to the change of the error per period
+     */
+    int16_t kd;
+    /**
+     * @brief Duty of both wheels if the line is centered
+     */
+    int16_t base;
+    /**
+     * @brief Sum of the errors, limited to plus minus #PID_INTEGRAL_LIMIT
+     */
+    int16_t integral;
+    /**
+     * @brief Filtered change of the error, contains #PID_DERIVATIVE_FRACTION fraction bits
+     */
+    int16_t derivative;
+    /**
+     * @brief Error of the last period
+     */
+    int16_t last_error;
+    /**
+     * @brief Time in milliseconds of the last period
+     */
+    uint32_t last_time;
+} pid_controller;
+
+/**
+ * @brief Stages of the search for a lost line, see @ref secDriLost
+ */
+typedef enum {
+    /**
+     * @brief The line is below the robot
+     */
+    RECOVER_NONE,
+    /**
+     * @brief Slower, but keeping the last heading
+     */
+    RECOVER_HOLD,
+    /**
+     * @brief Turning on the spot to both sides with a growing angle
+     */
+    RECOVER_SWEEP,
+    /**
+     * @brief The budget ran out, the robot stopped
+     */
+    RECOVER_FAILED
+} recover_stage;
+
+/**
+ * @brief State of the search for a lost line
+ */
+typedef struct line_recovery {
+    /**
+     * @brief Current stage of the search
+     */
+    uint8_t stage;
+    /**
+     * @brief Number of the current turn of the sweep, starting at zero
+     */
+    uint8_t sweep;
+    /**
+     * @brief Direction of the first turn of the sweep, where the line was seen last
+     */
+    uint8_t side;
+    /**
+     * @brief Time in milliseconds the line was lost
+     */
+    uint32_t lost_since;
+    /**
+     * @brief Time in milliseconds the current stage or turn started
+     */
+    uint32_t stage_since;
+} line_recovery;
 
 /**
  * @brief Current state of the driving action.
@@ -220,10 +318,13 @@ typedef struct track_state {
      */
     led_state last_led;
     /**
-     * @brief Count of seconds of the robot on the board. A value from 0 to 2. If the robot is not
-     * on the start field this is 0.
+     * @brief Time in milliseconds when all sensors started to see the start field
      */
-    uint8_t homeCache;
+    uint32_t home_since;
+    /**
+     * @brief Debounces the state of the sensors, #sensor_current is its stable state
+     */
+    debounce sensor_debounce;
     /**
      * @brief If the action state was activated since the last util_reset at least once.
      */
@@ -239,9 +340,13 @@ typedef struct track_state {
      */
     direction manual_dir;
     /**
-     * @brief If the manuel mode drove in the last manual tick
+     * @brief Speed level of the manual control, 0 to #MANUAL_LEVEL_AMOUNT - 1
      */
-    uint8_t manual_dir_last;
+    uint8_t manual_level;
+    /**
+     * @brief Time in milliseconds the last manual command was received
+     */
+    uint32_t manual_time;
     /**
      * @brief If the robot was driving before manual was called.
      */
@@ -262,6 +367,59 @@ typedef struct track_state {
      * @brief Connection state to the ui
      */
     ui_state ui_connection;
+    /**
+     * @brief Time in milliseconds when the calibration was started
+     */
+    uint32_t calib_start;
+    /**
+     * @brief Logic that follows the line, selected at runtime
+     */
+    drive_logic logic;
+    /**
+     * @brief Controller of the #DRIVE_LOGIC_PID
+     */
+    pid_controller pid;
+    /**
+     * @brief If the robot drives faster on the straights it learned in the first round
+     */
+    uint8_t learning;
+    /**
+     * @brief If the speed is set from the live classification of the track
+     */
+    uint8_t classify;
+    /**
+     * @brief Classifier of the part of the track the robot is on
+     */
+    curve_classifier classifier;
+    /**
+     * @brief Time in milliseconds the pid controller looks ahead with the estimator, 0 if it
+     * uses the measured offset
+     */
+    uint8_t estimate_lead;
+    /**
+     * @brief Estimator of the offset of the line for the pid controller
+     */
+    line_estimator estimator;
+    /**
+     * @brief Search for the line if it got lost while following it
+     */
+    line_recovery recovery;
+    /**
+     * @brief Duty of the active brake, 0 if the wheels only coast, see @ref secDriBrake
+     */
+    uint8_t brake_duty;
+    /**
+     * @brief Time in milliseconds the current brake takes, 0 if the robot does not brake
+     */
+    uint16_t brake_time;
+    /**
+     * @brief Time in milliseconds the current brake started
+     */
+    uint32_t brake_since;
+    /**
+     * @brief Label the speed scheduling selected in the last cycle
+     */
+    segment_class speed_last;
 } track_state;
 
 /**